@@ -0,0 +1,278 @@
+#include "alarm_engine.h"
+#include <cmath>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include "string_util.h"
+
+namespace {
+bool is_named_threshold(const std::string& value) {
+    return value == "medium" || value == "high" || value == "critical";
+}
+}
+
+AlarmEngine::AlarmEngine(const Config& cfg) : config(cfg) {
+    std::lock_guard<std::mutex> lock(mutex);
+    reload_locked(nullptr);
+}
+
+void AlarmEngine::reload_locked(std::vector<json>* removed) {
+    // 다른 설정만 바뀐 재적재(SIGHUP, 파일 수정)에서는 규칙과 진행 중인 알람 상태를 그대로 유지
+    bool initial = !loaded;
+    loaded = config.tunables();
+    if (!initial && loaded->alarm_rules == rules_text) return;
+    rules_text = loaded->alarm_rules;
+
+    auto previous = std::move(rules);
+    rules.clear();
+
+    // "KEY:opt=v,opt=v;KEY:..." 파싱 (같은 KEY를 여러 번 쓰면 규칙 여러 개)
+    std::stringstream entries(rules_text);
+    std::string entry;
+    size_t count = 0;
+    while (std::getline(entries, entry, ';')) {
+        entry = string_util::trim(entry);
+        size_t colon = entry.find(':');
+        if (entry.empty() || colon == std::string::npos) continue;
+
+        std::string key = string_util::trim(entry.substr(0, colon));
+        Rule rule;
+        // 디바이스별 규칙도 이름에는 log_code만 남김 (alarm_id = device_id/이름)
+        size_t slash = key.find('/');
+        rule.name = (slash == std::string::npos ? key : key.substr(slash + 1)) + entry.substr(colon);
+        bool has_condition = false;
+        std::stringstream options(entry.substr(colon + 1));
+        std::string option;
+        try {
+            while (std::getline(options, option, ',')) {
+                size_t eq = option.find('=');
+                if (eq == std::string::npos) continue;
+                std::string name = string_util::trim(option.substr(0, eq));
+                std::string value = string_util::trim(option.substr(eq + 1));
+                if (name == "above" || name == "below" || name == "rate") {
+                    rule.kind = name == "above" ? Rule::Kind::ABOVE
+                              : name == "below" ? Rule::Kind::BELOW : Rule::Kind::RATE;
+                    if (name != "rate" && is_named_threshold(value)) rule.named_threshold = value;
+                    else rule.threshold = std::stod(value);
+                    has_condition = true;
+                }
+                else if (name == "hysteresis") rule.hysteresis = std::stod(value);
+                else if (name == "sustain") rule.sustain_ms = std::stoll(value);
+                else std::cerr << "Unknown alarm rule option: " << name << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid alarm rule '" << entry << "': " << e.what() << std::endl;
+            continue;
+        }
+        if (!has_condition) {
+            std::cerr << "Alarm rule without above/below/rate: " << entry << std::endl;
+            continue;
+        }
+        rules[key].push_back(std::move(rule));
+        ++count;
+    }
+
+    if (count > 0) {
+        std::cout << "Alarm rules loaded: " << count << std::endl;
+    }
+    if (initial) return;
+
+    // 정의가 같은 규칙(이름 기준)은 상태를 넘겨받고, 없어진 규칙의 발생 중 알람은 해제 처리
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    for (auto it = streams.begin(); it != streams.end();) {
+        StreamState& stream = it->second;
+        const std::vector<Rule>* old_rules = nullptr;
+        if (auto found = previous.find(it->first); found != previous.end()) old_rules = &found->second;
+        else if (auto found = previous.find(stream.log_code); found != previous.end()) old_rules = &found->second;
+        const std::vector<Rule>* new_rules = find_rules(stream.device_id, stream.log_code);
+
+        std::vector<RuleState> carried(new_rules ? new_rules->size() : 0);
+        std::vector<bool> taken(carried.size(), false);
+        for (size_t i = 0; old_rules && i < old_rules->size() && i < stream.rules.size(); ++i) {
+            const Rule& old_rule = (*old_rules)[i];
+            bool kept = false;
+            for (size_t j = 0; j < carried.size(); ++j) {
+                if (!taken[j] && (*new_rules)[j].name == old_rule.name) {
+                    carried[j] = stream.rules[i];
+                    taken[j] = kept = true;
+                    break;
+                }
+            }
+            if (!kept && stream.rules[i].active) {
+                ++cleared;
+                if (removed) {
+                    removed->push_back(json{{"alarm_id", stream.device_id + "/" + old_rule.name},
+                                            {"device_id", stream.device_id},
+                                            {"log_code", stream.log_code},
+                                            {"rule", old_rule.name},
+                                            {"state", "cleared"},
+                                            {"reason", "rule_removed"},
+                                            {"value", stream.last_value},
+                                            {"threshold", stream.rules[i].threshold},
+                                            {"timestamp", stream.last_timestamp},
+                                            {"since", stream.rules[i].pending_since},
+                                            {"detected_at", now}});
+                }
+            }
+        }
+
+        if (carried.empty()) {
+            it = streams.erase(it);
+        } else {
+            stream.rules = std::move(carried);
+            ++it;
+        }
+    }
+}
+
+const std::vector<AlarmEngine::Rule>* AlarmEngine::find_rules(const std::string& device_id,
+                                                              const std::string& log_code) const {
+    auto it = rules.find(device_id + "/" + log_code);
+    if (it != rules.end()) return &it->second;
+    it = rules.find(log_code);
+    return it != rules.end() ? &it->second : nullptr;
+}
+
+bool AlarmEngine::resolve_threshold(const Rule& rule, const SeverityRules& severity_rules, double& threshold) {
+    if (rule.named_threshold.empty()) {
+        threshold = rule.threshold;
+        return true;
+    }
+    // 디바이스 문서에 temperature 임계값이 없으면 이 디바이스에는 적용하지 않음
+    if (!severity_rules.temperature_valid) return false;
+    threshold = rule.named_threshold == "critical" ? severity_rules.temperature_critical
+              : rule.named_threshold == "high" ? severity_rules.temperature_high
+              : severity_rules.temperature_medium;
+    return true;
+}
+
+void AlarmEngine::evaluate(const std::string& device_id,
+                           const TelemetryRecord& record,
+                           int64_t timestamp,
+                           const SeverityRules& severity_rules,
+                           const std::string& severity,
+                           std::vector<json>& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (config.tunables() != loaded) reload_locked(&out);
+    if (rules.empty()) return;
+
+    const std::vector<Rule>* stream_rules = find_rules(device_id, record.log_code);
+    if (!stream_rules) return;
+
+    double value = 0.0;
+    bool numeric = string_util::parse_numeric(record.message, value);
+    if (!numeric && record.metadata.is_object() && record.metadata.contains("temperature") &&
+        record.metadata["temperature"].is_number()) {
+        value = record.metadata["temperature"].get<double>();
+        numeric = true;
+    }
+    if (!numeric) return;
+
+    StreamState& stream = streams[device_id + "/" + record.log_code];
+    if (stream.device_id.empty()) {
+        stream.device_id = device_id;
+        stream.log_code = record.log_code;
+    }
+    if (stream.has_last && timestamp < stream.last_timestamp) {
+        ++stale;   // 재전송된 과거 로그로 현재 알람 상태를 바꾸지 않음
+        return;
+    }
+    ++evaluated;
+    stream.rules.resize(stream_rules->size());
+
+    bool has_rate = stream.has_last && timestamp > stream.last_timestamp;
+    double rate = has_rate ? (value - stream.last_value) / ((timestamp - stream.last_timestamp) / 1000.0) : 0.0;
+    int64_t detected_at = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    for (size_t i = 0; i < stream_rules->size(); ++i) {
+        const Rule& rule = (*stream_rules)[i];
+        RuleState& state = stream.rules[i];
+
+        double threshold = 0.0;
+        if (!resolve_threshold(rule, severity_rules, threshold)) continue;
+
+        double observed = value;
+        bool condition = false;
+        bool clear = false;
+        switch (rule.kind) {
+            case Rule::Kind::ABOVE:
+                condition = value >= threshold;
+                clear = value < threshold - rule.hysteresis;
+                break;
+            case Rule::Kind::BELOW:
+                condition = value <= threshold;
+                clear = value > threshold + rule.hysteresis;
+                break;
+            case Rule::Kind::RATE:
+                if (!has_rate) continue;
+                observed = rate;
+                condition = std::fabs(rate) >= threshold;
+                clear = std::fabs(rate) < threshold - rule.hysteresis;
+                break;
+        }
+
+        auto event = [&](const char* transition) {
+            return json{{"alarm_id", device_id + "/" + rule.name},
+                        {"device_id", device_id},
+                        {"log_code", record.log_code},
+                        {"rule", rule.name},
+                        {"state", transition},
+                        {"value", observed},
+                        {"threshold", threshold},
+                        {"severity", severity},
+                        {"timestamp", timestamp},
+                        {"since", state.pending_since},
+                        {"detected_at", detected_at}};
+        };
+
+        if (!state.active) {
+            if (!condition) {
+                state.pending = false;
+                continue;
+            }
+            if (!state.pending) {
+                state.pending = true;
+                state.pending_since = timestamp;
+            }
+            if (timestamp - state.pending_since >= rule.sustain_ms) {
+                state.active = true;
+                state.threshold = threshold;
+                out.push_back(event("raised"));
+                ++raised;
+            }
+        } else if (clear) {
+            state.active = false;
+            state.pending = false;
+            out.push_back(event("cleared"));
+            ++cleared;
+        }
+    }
+
+    stream.has_last = true;
+    stream.last_value = value;
+    stream.last_timestamp = timestamp;
+}
+
+json AlarmEngine::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t rule_count = 0;
+    for (const auto& [key, list] : rules) rule_count += list.size();
+
+    json active = json::array();
+    for (const auto& [key, stream] : streams) {
+        for (const auto& state : stream.rules) {
+            if (state.active) active.push_back(key);
+        }
+    }
+
+    json result;
+    result["rules"] = rule_count;
+    result["evaluated"] = evaluated;
+    result["raised"] = raised;
+    result["cleared"] = cleared;
+    result["stale"] = stale;
+    result["active"] = std::move(active);
+    return result;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "config.h"
+#include "telemetry_record.h"
+#include "device_context.h"
+
+using json = nlohmann::json;
+
+// 수신 경로 알람 감지 (DB 조회 없이 메시지와 캐시된 디바이스 임계값만 사용)
+// ALARM_RULES="TMP:above=high,hysteresis=2,sustain=30000;TMP:above=critical;SPD:rate=50;robot_arm_01/SPD:below=10"
+// - above / below: 임계값 (숫자, 또는 medium / high / critical = 디바이스 thresholds.temperature 값)
+// - hysteresis:    해제 기준 (above는 임계값 - H 미만, below는 임계값 + H 초과, rate는 R - H 미만일 때 해제)
+// - sustain:       조건이 이벤트 시각 기준 T ms 이상 계속되어야 발생 ("30초 이상 HIGH")
+// - rate:          직전 값 대비 초당 변화량의 절대값이 R 이상이면 발생
+// 숫자 값은 메시지("^[0-9]+$") 또는 metadata.temperature에서 읽는다.
+// 발생(raised) / 해제(cleared) 상태가 바뀔 때만 이벤트를 만들고, 이미 본 것보다 이른 이벤트 시각의 로그는 평가하지 않는다.
+class AlarmEngine {
+public:
+    struct Rule {
+        enum class Kind { ABOVE, BELOW, RATE };
+        Kind kind = Kind::ABOVE;
+        double threshold = 0.0;
+        std::string named_threshold;   // "medium" / "high" / "critical" (디바이스별 값)
+        double hysteresis = 0.0;
+        int64_t sustain_ms = 0;
+        std::string name;              // 이벤트에 넣는 규칙 이름 ("TMP:above=high")
+    };
+
+private:
+    struct RuleState {
+        bool active = false;
+        bool pending = false;
+        int64_t pending_since = 0;     // 조건이 처음 만족된 이벤트 시각
+        double threshold = 0.0;        // 발생 시 적용한 임계값
+    };
+
+    struct StreamState {
+        std::string device_id;
+        std::string log_code;
+        bool has_last = false;
+        double last_value = 0.0;
+        int64_t last_timestamp = 0;
+        std::vector<RuleState> rules;  // 규칙 순서와 동일
+    };
+
+    const Config& config;
+    std::shared_ptr<const Tunables> loaded;        // 마지막으로 확인한 설정 스냅샷
+    std::string rules_text;                        // 현재 규칙의 ALARM_RULES 원문
+
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<Rule>> rules;   // "log_code" 또는 "device_id/log_code"
+    std::unordered_map<std::string, StreamState> streams;       // "device_id/log_code"
+    uint64_t evaluated = 0;
+    uint64_t raised = 0;
+    uint64_t cleared = 0;
+    uint64_t stale = 0;
+
+    // ALARM_RULES가 바뀐 경우만 규칙을 다시 읽음 (삭제된 규칙의 발생 중 알람은 cleared 이벤트를 removed에 추가)
+    void reload_locked(std::vector<json>* removed);
+    const std::vector<Rule>* find_rules(const std::string& device_id, const std::string& log_code) const;
+    static bool resolve_threshold(const Rule& rule, const SeverityRules& severity_rules, double& threshold);
+
+public:
+    AlarmEngine(const Config& cfg);
+
+    // 레코드 평가 후 상태가 바뀐 알람 이벤트를 out에 추가
+    void evaluate(const std::string& device_id,
+                  const TelemetryRecord& record,
+                  int64_t timestamp,
+                  const SeverityRules& severity_rules,
+                  const std::string& severity,
+                  std::vector<json>& out);
+
+    json stats();
+};
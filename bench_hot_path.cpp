@@ -0,0 +1,180 @@
+// 메시지 수신 경로 마이크로벤치마크 (토픽 파싱 → 페이로드 파싱 → 심각도 → 문서 빌드 → 조회 응답 직렬화)
+// 결과 저장: ./bench_hot_path --benchmark_out=bench_hot_path.json --benchmark_out_format=json
+#include <benchmark/benchmark.h>
+#include <regex>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <bsoncxx/json.hpp>
+#include "topic_router.h"
+#include "telemetry_record.h"
+#include "device_context.h"
+#include "log_document.h"
+#include "log_filter.h"
+#include "ulid.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// 실제 디바이스가 보내는 형태의 고정 페이로드
+const std::string SPEED_TOPIC = "factory/conveyor_01/log/info";
+const std::string SPEED_PAYLOAD = R"({"log_code":"SPD","message":"152","timestamp":1722153600123})";
+const std::string TEMPERATURE_TOPIC = "factory/robot_arm_01/log/warning";
+const std::string TEMPERATURE_PAYLOAD =
+    R"({"log_code":"TMP","message":"Temperature rising on joint 2","timestamp":1722153600456,)"
+    R"("metadata":{"temperature":72.5,"unit":"C","sensor":"J2","threshold":70.0}})";
+const std::string ERROR_PAYLOAD =
+    R"({"log_code":"COL","message":"Collision detected on axis 3","timestamp":1722153600789})";
+
+const std::string DEVICE_DOCUMENT = R"({
+    "_id": "robot_arm_01",
+    "device_code": "RA01",
+    "device_name": "Robot Arm 01",
+    "device_type": "robot_arm",
+    "location": "Line A / Cell 3",
+    "log_group": "/factory/line-a/robots",
+    "thresholds": {"temperature": {"medium": 60.0, "high": 70.0, "critical": 85.0}}
+})";
+
+const std::vector<std::string>& payloads() {
+    static const std::vector<std::string> values = {SPEED_PAYLOAD, TEMPERATURE_PAYLOAD, ERROR_PAYLOAD};
+    return values;
+}
+
+// 토픽 파싱: 라우터 도입 전 정규식 방식
+void BM_TopicRegex(benchmark::State& state) {
+    for (auto _ : state) {
+        std::regex topic_regex("factory/([^/]+)/");
+        std::regex log_topic_regex("factory/([^/]+)/log/([^/]+)");
+        std::smatch matches;
+        std::smatch log_matches;
+        bool ok = std::regex_search(TEMPERATURE_TOPIC, matches, topic_regex) &&
+                  std::regex_match(TEMPERATURE_TOPIC, log_matches, log_topic_regex);
+        benchmark::DoNotOptimize(ok);
+    }
+}
+
+void BM_TopicRouter(benchmark::State& state) {
+    DeviceTopic route;
+    for (auto _ : state) {
+        bool ok = DeviceTopic::parse(TEMPERATURE_TOPIC, route) && route.is_log();
+        benchmark::DoNotOptimize(ok);
+    }
+}
+
+// 페이로드 파싱: DOM (json::parse + from_json) vs 고정 필드 SAX 디코딩 (CBOR)
+void BM_JsonParse(benchmark::State& state) {
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const auto& payload : payloads()) {
+            auto record = TelemetryRecord::from_json(json::parse(payload));
+            benchmark::DoNotOptimize(record);
+            bytes += payload.size();
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+void BM_CborDecode(benchmark::State& state) {
+    std::vector<std::string> encoded;
+    for (const auto& payload : payloads()) {
+        auto cbor = json::to_cbor(json::parse(payload));
+        encoded.emplace_back(cbor.begin(), cbor.end());
+    }
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const auto& payload : encoded) {
+            TelemetryRecord record;
+            benchmark::DoNotOptimize(TelemetryRecord::decode(payload, PayloadFormat::CBOR, record));
+            bytes += payload.size();
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+void BM_GenerateUlid(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generate_ulid());
+    }
+}
+
+// 심각도: 메시지마다 디바이스 문서에서 규칙을 읽는 방식 vs 캐시된 규칙
+void BM_SeverityFromDocument(benchmark::State& state) {
+    auto device = bsoncxx::from_json(DEVICE_DOCUMENT);
+    json metadata = json::parse(TEMPERATURE_PAYLOAD)["metadata"];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SeverityRules::from_device(device.view()).evaluate("TMP", metadata));
+    }
+}
+
+void BM_SeverityCached(benchmark::State& state) {
+    auto rules = SeverityRules::from_device(bsoncxx::from_json(DEVICE_DOCUMENT).view());
+    json metadata = json::parse(TEMPERATURE_PAYLOAD)["metadata"];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(rules.evaluate("TMP", metadata));
+    }
+}
+
+void BM_LogStream(benchmark::State& state) {
+    auto now = std::chrono::system_clock::now();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(make_log_stream("robot_arm_01", "warning", now));
+    }
+}
+
+// 저장 문서 빌드 (metadata 포함 / 미포함)
+void BM_BuildLogDocument(benchmark::State& state) {
+    auto device = DeviceContext::from_device(bsoncxx::from_json(DEVICE_DOCUMENT).view());
+    auto record = TelemetryRecord::from_json(json::parse(state.range(0) ? TEMPERATURE_PAYLOAD : SPEED_PAYLOAD));
+    std::string log_stream = make_log_stream("robot_arm_01", "warning", std::chrono::system_clock::now());
+    std::string id = "RA01-TMP-01J3ZK8Q9X4M2N7P5R6S8T0V1W";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(build_log_document(id, "robot_arm_01", "warning", log_stream, TEMPERATURE_TOPIC,
+                                                    device, record, "HIGH", record.timestamp, record.timestamp));
+    }
+    state.SetLabel(state.range(0) ? "with metadata" : "no metadata");
+}
+
+// 조회 응답 직렬화 (BSON 결과 N건 → data 배열 → 문자열)
+void BM_QueryResponse(benchmark::State& state) {
+    auto device = DeviceContext::from_device(bsoncxx::from_json(DEVICE_DOCUMENT).view());
+    auto record = TelemetryRecord::from_json(json::parse(TEMPERATURE_PAYLOAD));
+    std::vector<bsoncxx::document::value> rows;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        rows.push_back(build_log_document("RA01-TMP-" + std::to_string(i), "robot_arm_01", "warning",
+                                          "robot_arm_01/2024/07/28/warning", TEMPERATURE_TOPIC,
+                                          device, record, "HIGH", record.timestamp + i, record.timestamp + i));
+    }
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        json response;
+        response["status"] = "success";
+        json data_array = json::array();
+        for (const auto& row : rows) data_array.push_back(log_document_to_json(row.view()));
+        response["count"] = data_array.size();
+        response["data"] = std::move(data_array);
+        std::string body = response.dump();
+        bytes += body.size();
+        benchmark::DoNotOptimize(body);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}
+
+BENCHMARK(BM_TopicRegex);
+BENCHMARK(BM_TopicRouter);
+BENCHMARK(BM_JsonParse);
+BENCHMARK(BM_CborDecode);
+BENCHMARK(BM_GenerateUlid);
+BENCHMARK(BM_SeverityFromDocument);
+BENCHMARK(BM_SeverityCached);
+BENCHMARK(BM_LogStream);
+BENCHMARK(BM_BuildLogDocument)->Arg(0)->Arg(1);
+BENCHMARK(BM_QueryResponse)->Arg(10)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN();
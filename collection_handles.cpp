@@ -0,0 +1,67 @@
+#include "collection_handles.h"
+#include <stdexcept>
+
+CollectionHandles::CollectionHandles(mongocxx::client& client, const Config& cfg)
+    : config(cfg), db(client[cfg.mongo_db_name()]),
+      logs_concern(parse_write_concern(cfg.write_concern_logs())),
+      statistics_concern(parse_write_concern(cfg.write_concern_statistics())) {
+    log_insert.ordered(false);
+    debug_insert.ordered(false);
+    auto debug_concern = cfg.write_concern_debug().empty() ? logs_concern
+                                                           : parse_write_concern(cfg.write_concern_debug());
+    if (debug_concern) debug_insert.write_concern(*debug_concern);
+
+    // 모든 메시지가 거치는 고정 컬렉션
+    for (const auto* name : {&cfg.all_logs_collection(), &cfg.statistics_collection(),
+                             &cfg.devices_collection(), &cfg.device_state_collection()}) {
+        collection(*name);
+    }
+}
+
+std::optional<mongocxx::write_concern> CollectionHandles::parse_write_concern(const std::string& spec) {
+    if (spec.empty()) return std::nullopt;
+
+    mongocxx::write_concern concern;
+    if (spec == "majority") {
+        concern.acknowledge_level(mongocxx::write_concern::level::k_majority);
+        return concern;
+    }
+    if (spec == "0") {
+        concern.acknowledge_level(mongocxx::write_concern::level::k_unacknowledged);
+        return concern;
+    }
+
+    size_t used = 0;
+    int nodes = 0;
+    try {
+        nodes = std::stoi(spec, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used != spec.size() || nodes < 1) {
+        throw std::invalid_argument("Invalid write concern: '" + spec + "'");
+    }
+    concern.nodes(nodes);
+    return concern;
+}
+
+mongocxx::collection& CollectionHandles::collection(const std::string& name) {
+    auto it = collections.find(name);
+    if (it != collections.end()) return it->second;
+
+    auto handle = db[name];
+    // 통계 / 디바이스 / 최신 상태는 유실되면 안 되므로 별도 write concern, 나머지는 로그 컬렉션
+    bool durable = name == config.statistics_collection() || name == config.devices_collection() ||
+                   name == config.device_state_collection();
+    const auto& concern = durable ? statistics_concern : logs_concern;
+    if (concern) handle.write_concern(*concern);
+    return collections.emplace(name, std::move(handle)).first->second;
+}
+
+void CollectionHandles::prepare(uint64_t generation, const std::vector<std::string>& names) {
+    if (generation == prepared_generation) return;
+    for (const auto& name : names) {
+        collection(name);
+    }
+    prepared_generation = generation;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <mongocxx/client.hpp>
+#include <mongocxx/database.hpp>
+#include <mongocxx/collection.hpp>
+#include <mongocxx/write_concern.hpp>
+#include <mongocxx/options/insert.hpp>
+#include "config.h"
+
+// 스레드(MQTT 콜백 / 요청 워커)별 database / collection 핸들 캐시
+// mongocxx 핸들은 클라이언트와 같은 스레드에서만 쓸 수 있으므로 스레드마다 하나씩 둔다.
+// 메시지마다 client[db] / db[name] 으로 핸들을 새로 만들지 않도록 이름별로 보관한다.
+// 핸들을 만들 때 컬렉션 종류(로그 / 통계·디바이스·상태)에 맞는 write concern을 지정한다.
+class CollectionHandles {
+private:
+    const Config& config;
+    mongocxx::database db;
+    std::unordered_map<std::string, mongocxx::collection> collections;
+    uint64_t prepared_generation = 0;
+
+    std::optional<mongocxx::write_concern> logs_concern;
+    std::optional<mongocxx::write_concern> statistics_concern;
+    mongocxx::options::insert log_insert;
+    mongocxx::options::insert debug_insert;
+
+public:
+    CollectionHandles(mongocxx::client& client, const Config& cfg);
+
+    // "1"/"2".. (노드 수), "majority", "0" (응답 없음), "" (서버 기본값) → 잘못된 값은 예외
+    static std::optional<mongocxx::write_concern> parse_write_concern(const std::string& spec);
+
+    mongocxx::database& database() { return db; }
+
+    // 캐시된 핸들 (처음 쓰는 이름이면 생성 후 보관)
+    mongocxx::collection& collection(const std::string& name);
+
+    // 로그 삽입 옵션 (순서 무관 삽입, debug 레벨은 WRITE_CONCERN_DEBUG 적용)
+    const mongocxx::options::insert& insert_options(const std::string& log_level) const {
+        return log_level == "debug" ? debug_insert : log_insert;
+    }
+
+    // 디바이스 캐시 적재 시 계산된 그룹 컬렉션 핸들 미리 생성 (세대가 바뀐 경우만)
+    void prepare(uint64_t generation, const std::vector<std::string>& names);
+
+    uint64_t generation() const { return prepared_generation; }
+    size_t size() const { return collections.size(); }
+};
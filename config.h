@@ -1,56 +1,316 @@
 #pragma once
 #include <string>
+#include <memory>
 #include <fstream>
 #include <sstream>
+#include <iostream>
+#include <stdexcept>
 #include <unordered_map>
 #include <chrono>
 
+// 실행 중 변경 가능한 설정 (SIGHUP 또는 설정 파일 변경 시 다시 읽어 통째로 교체)
+struct Tunables {
+    int64_t device_cache_ttl_sec = 300;
+    int64_t subscription_lease_ms = 60000;
+    int64_t subscription_max_lease_ms = 600000;
+    size_t subscription_max_count = 1000;
+    int64_t retention_days = 30;
+    std::string retention_level_days;
+    int64_t retention_interval_sec = 3600;
+    int64_t request_queue_max = 1000;
+    int64_t request_dedup_window_ms = 10000;
+    std::string ingest_policy;
+    std::string alarm_rules;
+};
+
 class Config {
 private:
-    std::unordered_map<std::string, std::string> config_map;
-    
-    void load_env_file(const std::string& filename) {
+    using Values = std::unordered_map<std::string, std::string>;
+
+    std::string config_file;
+    Values config_map;   // 시작 시 값 (get()은 이 값을 반환)
+
+    static Values load_env_file(const std::string& filename) {
+        Values values;
         std::ifstream file(filename);
         std::string line;
-        
+
         while (std::getline(file, line)) {
             if (line.empty() || line[0] == '#') continue;
-            
+
             size_t pos = line.find('=');
             if (pos != std::string::npos) {
                 std::string key = line.substr(0, pos);
                 std::string value = line.substr(pos + 1);
-                config_map[key] = value;
+                values[key] = value;
             }
         }
+        return values;
+    }
+
+    static std::string lookup(const Values& values, const std::string& key, const std::string& default_value) {
+        auto it = values.find(key);
+        return (it != values.end()) ? it->second : default_value;
+    }
+
+    // 숫자 설정 파싱 및 범위 검증 (잘못된 값은 키 이름과 함께 예외)
+    static int64_t number(const Values& values, const std::string& key, const std::string& default_value,
+                          int64_t min_value = 0) {
+        std::string text = lookup(values, key, default_value);
+        int64_t value = 0;
+        try {
+            size_t used = 0;
+            value = std::stoll(text, &used);
+            if (used != text.size()) throw std::invalid_argument(text);
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Invalid number for " + key + ": '" + text + "'");
+        }
+        if (value < min_value) {
+            throw std::invalid_argument(key + " must be >= " + std::to_string(min_value));
+        }
+        return value;
     }
 
+    static bool flag(const Values& values, const std::string& key, const std::string& default_value) {
+        return lookup(values, key, default_value) == "true";
+    }
+
+    static std::shared_ptr<const Tunables> parse_tunables(const Values& values) {
+        auto t = std::make_shared<Tunables>();
+        t->device_cache_ttl_sec = number(values, "DEVICE_CACHE_TTL_SEC", "300");
+        t->subscription_lease_ms = number(values, "SUBSCRIPTION_LEASE_MS", "60000", 1);
+        t->subscription_max_lease_ms = number(values, "SUBSCRIPTION_MAX_LEASE_MS", "600000", 1);
+        t->subscription_max_count = static_cast<size_t>(number(values, "SUBSCRIPTION_MAX_COUNT", "1000"));
+        t->retention_days = number(values, "RETENTION_DAYS", "30", 1);
+        t->retention_level_days = lookup(values, "RETENTION_LEVEL_DAYS", "");
+        t->retention_interval_sec = number(values, "RETENTION_INTERVAL_SEC", "3600", 1);
+        t->request_queue_max = number(values, "REQUEST_QUEUE_MAX", "1000", 1);
+        t->request_dedup_window_ms = number(values, "REQUEST_DEDUP_WINDOW_MS", "10000");
+        t->ingest_policy = lookup(values, "INGEST_POLICY", "");
+        t->alarm_rules = lookup(values, "ALARM_RULES", "");
+        return t;
+    }
+
+    // 시작 시 한 번 계산하는 값 (재시작해야 반영)
+    std::string mqtt_server_address_;
+    std::string mqtt_topic_;
+    std::string query_request_topic_;
+    std::string query_response_topic_;
+    std::string statistics_request_topic_;
+    std::string mongo_uri_;
+    std::string mongo_db_name_;
+    std::string devices_collection_;
+    std::string all_logs_collection_;
+    std::string statistics_collection_;
+    std::string subscription_topic_prefix_;
+    size_t query_cache_max_bytes_;
+    size_t response_compress_min_bytes_;
+    bool device_state_persist_;
+    std::string device_state_collection_;
+    int64_t device_state_flush_ms_;
+    bool retention_enabled_;
+    bool archive_enabled_;
+    std::string archive_dir_;
+    int64_t hot_store_hours_;
+    int64_t hot_store_partition_ms_;
+    int64_t request_workers_;
+    int64_t sketch_hours_;
+    int64_t sketch_bucket_ms_;
+    int64_t shutdown_timeout_ms_;
+    std::string snapshot_path_;
+    int64_t snapshot_interval_sec_;
+    int64_t snapshot_max_age_sec_;
+    int64_t trace_sample_every_;
+    int64_t trace_max_events_;
+    std::string trace_dump_path_;
+    bool log_writer_async_;
+    int64_t log_writer_batch_min_;
+    int64_t log_writer_batch_max_;
+    int64_t log_writer_batch_step_;
+    int64_t log_writer_flush_min_ms_;
+    int64_t log_writer_flush_max_ms_;
+    int64_t log_writer_target_latency_ms_;
+    int64_t log_writer_queue_max_;
+    std::string write_concern_logs_;
+    std::string write_concern_statistics_;
+    std::string write_concern_debug_;
+    std::string log_partition_;
+    int64_t allowed_lateness_ms_;
+
+    std::shared_ptr<const Tunables> tunables_;
+
 public:
-    Config(const std::string& config_file = "config.env") {
-        load_env_file(config_file);
+    Config(const std::string& config_file = "config.env")
+        : config_file(config_file), config_map(load_env_file(config_file)) {
+        const Values& v = config_map;
+        mqtt_server_address_ = lookup(v, "MQTT_SERVER_ADDRESS", "tcp://localhost:1883");
+        mqtt_topic_ = lookup(v, "MQTT_TOPIC", "factory/#");
+        query_request_topic_ = lookup(v, "QUERY_REQUEST_TOPIC", "factory/query/logs/request");
+        query_response_topic_ = lookup(v, "QUERY_RESPONSE_TOPIC", "factory/query/logs/response");
+        statistics_request_topic_ = lookup(v, "STATISTICS_REQUEST_TOPIC", "factory/statistics");
+        mongo_uri_ = lookup(v, "MONGO_URI", "mongodb://localhost:27017");
+        mongo_db_name_ = lookup(v, "MONGO_DB_NAME", "factory_monitoring");
+        devices_collection_ = lookup(v, "DEVICES_COLLECTION", "devices");
+        all_logs_collection_ = lookup(v, "ALL_LOGS_COLLECTION", "logs_all");
+        statistics_collection_ = lookup(v, "STATISTICS_COLLECTION", "statistics");
+        subscription_topic_prefix_ = lookup(v, "SUBSCRIPTION_TOPIC_PREFIX", "factory/query/logs/subscription/");
+        query_cache_max_bytes_ = static_cast<size_t>(number(v, "QUERY_CACHE_MAX_BYTES", "16777216"));
+        response_compress_min_bytes_ = static_cast<size_t>(number(v, "RESPONSE_COMPRESS_MIN_BYTES", "1024"));
+        device_state_persist_ = flag(v, "DEVICE_STATE_PERSIST", "false");
+        device_state_collection_ = lookup(v, "DEVICE_STATE_COLLECTION", "device_latest");
+        device_state_flush_ms_ = number(v, "DEVICE_STATE_FLUSH_MS", "1000", 10);
+        retention_enabled_ = flag(v, "RETENTION_ENABLED", "false");
+        archive_enabled_ = flag(v, "ARCHIVE_ENABLED", "true");
+        archive_dir_ = lookup(v, "ARCHIVE_DIR", "archive");
+        hot_store_hours_ = number(v, "HOT_STORE_HOURS", "2");
+        hot_store_partition_ms_ = number(v, "HOT_STORE_PARTITION_MS", "600000", 1);
+        request_workers_ = number(v, "REQUEST_WORKERS", "4", 1);
+        sketch_hours_ = number(v, "SKETCH_HOURS", "24");
+        sketch_bucket_ms_ = number(v, "SKETCH_BUCKET_MS", "300000", 1);
+        shutdown_timeout_ms_ = number(v, "SHUTDOWN_TIMEOUT_MS", "10000");
+        snapshot_path_ = lookup(v, "SNAPSHOT_PATH", "");
+        snapshot_interval_sec_ = number(v, "SNAPSHOT_INTERVAL_SEC", "60", 1);
+        snapshot_max_age_sec_ = number(v, "SNAPSHOT_MAX_AGE_SEC", "3600");
+        trace_sample_every_ = number(v, "TRACE_SAMPLE_EVERY", "0");
+        trace_max_events_ = number(v, "TRACE_MAX_EVENTS", "20000");
+        trace_dump_path_ = lookup(v, "TRACE_DUMP_PATH", "trace.json");
+        log_writer_async_ = flag(v, "LOG_WRITER_ASYNC", "false");
+        log_writer_batch_min_ = number(v, "LOG_WRITER_BATCH_MIN", "16", 1);
+        log_writer_batch_max_ = number(v, "LOG_WRITER_BATCH_MAX", "1000", log_writer_batch_min_);
+        log_writer_batch_step_ = number(v, "LOG_WRITER_BATCH_STEP", "16", 1);
+        log_writer_flush_min_ms_ = number(v, "LOG_WRITER_FLUSH_MIN_MS", "5", 1);
+        log_writer_flush_max_ms_ = number(v, "LOG_WRITER_FLUSH_MAX_MS", "200", log_writer_flush_min_ms_);
+        log_writer_target_latency_ms_ = number(v, "LOG_WRITER_TARGET_LATENCY_MS", "50", 1);
+        log_writer_queue_max_ = number(v, "LOG_WRITER_QUEUE_MAX", "50000", 1);
+        write_concern_logs_ = lookup(v, "WRITE_CONCERN_LOGS", "1");
+        write_concern_statistics_ = lookup(v, "WRITE_CONCERN_STATISTICS", "majority");
+        write_concern_debug_ = lookup(v, "WRITE_CONCERN_DEBUG", "");
+        allowed_lateness_ms_ = number(v, "ALLOWED_LATENESS_MS", "60000");
+        log_partition_ = lookup(v, "LOG_PARTITION", "none");
+        if (log_partition_ != "none" && log_partition_ != "day" && log_partition_ != "month") {
+            throw std::invalid_argument("LOG_PARTITION must be none, day or month: '" + log_partition_ + "'");
+        }
+        tunables_ = parse_tunables(v);
     }
-    
+
     std::string get(const std::string& key, const std::string& default_value = "") const {
-        auto it = config_map.find(key);
-        return (it != config_map.end()) ? it->second : default_value;
+        return lookup(config_map, key, default_value);
     }
-    
+
+    const std::string& file() const { return config_file; }
+
+    // 현재 설정 스냅샷 (읽는 동안 교체되어도 안전)
+    std::shared_ptr<const Tunables> tunables() const { return std::atomic_load(&tunables_); }
+
+    // 설정 파일을 다시 읽어 Tunables 교체 (검증 실패 시 기존 값 유지)
+    bool reload() {
+        try {
+            auto next = parse_tunables(load_env_file(config_file));
+            std::atomic_store(&tunables_, next);
+            std::cout << "Configuration reloaded from " << config_file << std::endl;
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "Configuration reload rejected: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
     // 설정값 접근 함수들
-    std::string mqtt_server_address() const { return get("MQTT_SERVER_ADDRESS", "tcp://localhost:1883"); }
-    std::string mqtt_topic() const { return get("MQTT_TOPIC", "factory/#"); }
-    std::string query_request_topic() const { return get("QUERY_REQUEST_TOPIC", "factory/query/logs/request"); }
-    std::string query_response_topic() const { return get("QUERY_RESPONSE_TOPIC", "factory/query/logs/response"); }
-    std::string statistics_request_topic() const { return get("STATISTICS_REQUEST_TOPIC", "factory/statistics"); }
-
-    std::string mongo_uri() const { return get("MONGO_URI", "mongodb://localhost:27017"); }
-    std::string mongo_db_name() const { return get("MONGO_DB_NAME", "factory_monitoring"); }
-    std::string devices_collection() const { return get("DEVICES_COLLECTION", "devices"); }
-    std::string all_logs_collection() const { return get("ALL_LOGS_COLLECTION", "logs_all"); }
-    std::string statistics_collection() const { return get("STATISTICS_COLLECTION", "statistics"); }
-    
+    const std::string& mqtt_server_address() const { return mqtt_server_address_; }
+    const std::string& mqtt_topic() const { return mqtt_topic_; }
+    const std::string& query_request_topic() const { return query_request_topic_; }
+    const std::string& query_response_topic() const { return query_response_topic_; }
+    const std::string& statistics_request_topic() const { return statistics_request_topic_; }
+
+    const std::string& mongo_uri() const { return mongo_uri_; }
+    const std::string& mongo_db_name() const { return mongo_db_name_; }
+    const std::string& devices_collection() const { return devices_collection_; }
+    int64_t device_cache_ttl_sec() const { return tunables()->device_cache_ttl_sec; }
+    const std::string& all_logs_collection() const { return all_logs_collection_; }
+    const std::string& statistics_collection() const { return statistics_collection_; }
+
+    // 실시간 구독 설정
+    const std::string& subscription_topic_prefix() const { return subscription_topic_prefix_; }
+    int64_t subscription_lease_ms() const { return tunables()->subscription_lease_ms; }
+    int64_t subscription_max_lease_ms() const { return tunables()->subscription_max_lease_ms; }
+    size_t subscription_max_count() const { return tunables()->subscription_max_count; }
+
+    // 조회 캐시 설정 (0이면 비활성화)
+    size_t query_cache_max_bytes() const { return query_cache_max_bytes_; }
+    // 조회 응답 압축 최소 크기 (이보다 작은 응답은 압축 요청이 있어도 그대로 전송)
+    size_t response_compress_min_bytes() const { return response_compress_min_bytes_; }
+
+    // 디바이스 최신 상태 테이블 (MongoDB 저장은 선택)
+    bool device_state_persist() const { return device_state_persist_; }
+    const std::string& device_state_collection() const { return device_state_collection_; }
+    // 변경된 디바이스 상태를 모아 저장하는 주기
+    int64_t device_state_flush_ms() const { return device_state_flush_ms_; }
+
+    // 보존 기간 및 아카이브 설정
+    bool retention_enabled() const { return retention_enabled_; }
+    int64_t retention_days() const { return tunables()->retention_days; }
+    std::string retention_level_days() const { return tunables()->retention_level_days; }
+    int64_t retention_interval_sec() const { return tunables()->retention_interval_sec; }
+    bool archive_enabled() const { return archive_enabled_; }
+    const std::string& archive_dir() const { return archive_dir_; }
+
+    // 최근 로그 메모리 컬럼 저장소 (0시간이면 비활성화)
+    int64_t hot_store_hours() const { return hot_store_hours_; }
+    int64_t hot_store_partition_ms() const { return hot_store_partition_ms_; }
+
+    // 숫자 센서 로그 저장 정책 (deadband / interval / window)
+    std::string ingest_policy() const { return tunables()->ingest_policy; }
+
+    // 알람 규칙 (임계값 / 히스테리시스 / 지속 시간 / 변화율, 비어 있으면 비활성화)
+    std::string alarm_rules() const { return tunables()->alarm_rules; }
+
+    // 요청 처리 워커 / 중복 제거
+    int64_t request_workers() const { return request_workers_; }
+    int64_t request_queue_max() const { return tunables()->request_queue_max; }
+    int64_t request_dedup_window_ms() const { return tunables()->request_dedup_window_ms; }
+
+    // 통계 스케치 설정 (분위수/고유 에러 수)
+    int64_t sketch_hours() const { return sketch_hours_; }
+    int64_t sketch_bucket_ms() const { return sketch_bucket_ms_; }
+
+    // 메모리 상태 스냅샷 (경로가 비어 있으면 비활성화)
+    const std::string& snapshot_path() const { return snapshot_path_; }
+    int64_t snapshot_interval_sec() const { return snapshot_interval_sec_; }
+    int64_t snapshot_max_age_sec() const { return snapshot_max_age_sec_; }
+
+    // 단계별 지연 추적 (N번째 메시지마다 샘플링, 0이면 비활성화)
+    int64_t trace_sample_every() const { return trace_sample_every_; }
+    int64_t trace_max_events() const { return trace_max_events_; }
+    const std::string& trace_dump_path() const { return trace_dump_path_; }
+
+    // 로그 비동기 배치 기록 (삽입 지연과 큐 길이로 배치 크기 / flush 간격 자동 조정)
+    bool log_writer_async() const { return log_writer_async_; }
+    int64_t log_writer_batch_min() const { return log_writer_batch_min_; }
+    int64_t log_writer_batch_max() const { return log_writer_batch_max_; }
+    int64_t log_writer_batch_step() const { return log_writer_batch_step_; }
+    int64_t log_writer_flush_min_ms() const { return log_writer_flush_min_ms_; }
+    int64_t log_writer_flush_max_ms() const { return log_writer_flush_max_ms_; }
+    int64_t log_writer_target_latency_ms() const { return log_writer_target_latency_ms_; }
+    int64_t log_writer_queue_max() const { return log_writer_queue_max_; }
+
+    // 컬렉션 종류별 write concern ("1", "majority", "0"=응답 없음, 비어 있으면 서버 기본값)
+    // debug 레벨 로그는 WRITE_CONCERN_DEBUG가 비어 있으면 로그 설정을 따름
+    const std::string& write_concern_logs() const { return write_concern_logs_; }
+    const std::string& write_concern_statistics() const { return write_concern_statistics_; }
+    const std::string& write_concern_debug() const { return write_concern_debug_; }
+
+    // 이벤트 시각(디바이스 timestamp) 기준 집계에서 늦게 도착한 로그를 반영하는 허용 지연
+    int64_t allowed_lateness_ms() const { return allowed_lateness_ms_; }
+
+    // logs_all 시간 파티션 (none / day / month → logs_all_YYYY_MM_DD / logs_all_YYYY_MM)
+    const std::string& log_partition() const { return log_partition_; }
+
+    // 종료 시 요청 큐 처리 / 집계 저장 / 연결 종료까지 허용 시간
+    int64_t shutdown_timeout_ms() const { return shutdown_timeout_ms_; }
+
     std::string mqtt_client_id() const {
-        return "factory_monitor_db_writer_" + 
+        return "factory_monitor_db_writer_" +
                std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
                    std::chrono::system_clock::now().time_since_epoch()).count());
     }
-};
\ No newline at end of file
+};
@@ -1,103 +1,263 @@
 #include "database_manager.h"
+#include "ulid.h"
+#include "log_document.h"
+#include "string_util.h"
 #include <iostream>
 #include <chrono>
 #include <algorithm>
-#include <random>
 #include <bsoncxx/builder/stream/document.hpp>
 #include <bsoncxx/json.hpp>
 #include <bsoncxx/types.hpp>
-#include <mongocxx/uri.hpp>
 #include <regex>
+#include <unordered_set>
+#include <map>
 
 using bson_builder = bsoncxx::builder::stream::document;
 using bsoncxx::builder::stream::finalize;
 
-// ULID 생성 함수 (utils에서 이동)
-std::string generate_ulid() {
-    static const char* ENCODING = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
-    auto now = std::chrono::system_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-
-    std::random_device rd;
-    std::mt19937_64 gen(rd());
-    std::uniform_int_distribution<uint64_t> dis;
-
-    uint64_t rand_high = dis(gen);
-    uint64_t rand_low = dis(gen);
-
-    char ulid[27];
-    ulid[26] = 0;
-
-    // Timestamp (48 bits)
-    ulid[0] = ENCODING[(ms >> 45) & 0x1F];
-    ulid[1] = ENCODING[(ms >> 40) & 0x1F];
-    ulid[2] = ENCODING[(ms >> 35) & 0x1F];
-    ulid[3] = ENCODING[(ms >> 30) & 0x1F];
-    ulid[4] = ENCODING[(ms >> 25) & 0x1F];
-    ulid[5] = ENCODING[(ms >> 20) & 0x1F];
-    ulid[6] = ENCODING[(ms >> 15) & 0x1F];
-    ulid[7] = ENCODING[(ms >> 10) & 0x1F];
-    ulid[8] = ENCODING[(ms >> 5) & 0x1F];
-    ulid[9] = ENCODING[ms & 0x1F];
-
-    // Randomness (80 bits)
-    auto encode_random = [&](uint64_t r, int start_idx) {
-        for (int i = 0; i < 8; ++i) {
-            ulid[start_idx + i] = ENCODING[r & 0x1F];
-            r >>= 5;
-        }
-    };
-    encode_random(rand_low, 10);
-    encode_random(rand_high, 18);
-
-    return std::string(ulid);
-}
-
-DatabaseManager::DatabaseManager(const Config& cfg) : config(cfg) {}
+DatabaseManager::DatabaseManager(const Config& cfg) : config(cfg), subscriptions(cfg), query_cache(cfg), log_archive(cfg), hot_store(cfg), sketches(cfg), device_cache(cfg), request_dedup(cfg), ingest_policy(cfg),
+      event_clock(cfg), alarms(cfg), partitions(cfg), snapshots(cfg, device_cache, device_states, sketches, partitions), tracer(cfg),
+      log_writer(cfg, partitions), response_encoder(cfg), state_persister(cfg, device_states) {}
 
-bsoncxx::stdx::optional<bsoncxx::document::value> DatabaseManager::get_device_info(
-    mongocxx::database& db, const std::string& device_id) {
+DeviceCache::DevicePtr DatabaseManager::get_device_info(
+    CollectionHandles& handles, const std::string& device_id) {
     try {
-        auto collection = db[config.devices_collection()];
-        bson_builder builder;
-        builder << "_id" << device_id;
-        return collection.find_one(builder.view());
+        auto device = device_cache.get(handles, device_id);
+        if (handles.generation() != device_cache.generation()) {
+            handles.prepare(device_cache.generation(), device_cache.group_collections());
+        }
+        return device;
     } catch (const std::exception& e) {
         std::cerr << "Error finding device '" << device_id << "': " << e.what() << std::endl;
-        return bsoncxx::stdx::nullopt;
+        return nullptr;
     }
 }
 
 std::string DatabaseManager::determine_severity(const std::string& log_code, 
                                               const json& metadata, 
                                               const bsoncxx::document::view& device_info) {
-    try {
-        if (!device_info["thresholds"]) return "UNKNOWN";
-        auto thresholds = device_info["thresholds"].get_document().view();
+    return SeverityRules::from_device(device_info).evaluate(log_code, metadata);
+}
+
+// 저장 정책 window 집계로 만들어진 레코드 (원본 로그가 아님)
+static bool is_aggregate_record(const TelemetryRecord& record) {
+    return record.metadata.is_object() && record.metadata.contains("aggregation");
+}
 
-        if (log_code == "TMP" && metadata.contains("temperature") && thresholds["temperature"]) {
-            double temp = metadata["temperature"];
-            if (temp >= thresholds["temperature"]["critical"].get_double()) return "CRITICAL";
-            if (temp >= thresholds["temperature"]["high"].get_double()) return "HIGH";
-            if (temp >= thresholds["temperature"]["medium"].get_double()) return "MEDIUM";
-            return "LOW";
+// 캐시된 응답 본문에 요청별 query_id 추가
+static std::string with_query_id(const std::string& body, const std::string& query_id) {
+    return "{\"query_id\":" + json(query_id).dump() + "," + body.substr(1);
+}
+
+// 조회 결과 병합 (최신순, _id 중복 제거, 최대 limit개)
+static json merge_by_timestamp(const json& primary, const json& secondary, int limit) {
+    std::vector<json> rows;
+    std::unordered_set<std::string> seen;
+    for (const auto* source : {&primary, &secondary}) {
+        for (const auto& row : *source) {
+            if (seen.insert(row.value("_id", "")).second) rows.push_back(row);
         }
-        // 다른 log_code (COL, SPD 등)에 대한 규칙을 여기에 추가
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const json& a, const json& b) {
+        return a.value("timestamp", int64_t{0}) > b.value("timestamp", int64_t{0});
+    });
+    if (rows.size() > static_cast<size_t>(limit)) rows.resize(limit);
+    return json(rows);
+}
 
-    } catch (const std::exception& e) {
-        std::cerr << "Error determining severity: " << e.what() << std::endl;
+json DatabaseManager::find_logs(CollectionHandles& handles, const LogFilter& filter, int limit) {
+    using bsoncxx::builder::stream::document;
+
+    auto filter_doc = filter.to_bson();
+
+    mongocxx::options::find opts{};
+    opts.limit(limit);
+    opts.sort(document{} << "timestamp" << -1 << finalize); // 최신순 정렬
+
+    // 시간 범위와 겹치는 파티션만 최신순으로 조회해 병합
+    // limit개를 채운 뒤에는 구간 전체가 지금까지 결과보다 오래된 파티션은 건너뜀
+    json data_array = json::array();
+    for (const auto& name : partitions.select(filter.has_time_range, filter.start_time, filter.end_time)) {
+        int64_t begin = 0, end = 0;
+        if (data_array.size() >= static_cast<size_t>(limit) && partitions.range_of(name, begin, end) &&
+            end <= data_array.back().value("timestamp", int64_t{0})) {
+            continue;
+        }
+
+        json rows = json::array();
+        for (auto&& doc : handles.collection(name).find(filter_doc.view(), opts)) {
+            rows.push_back(log_document_to_json(doc));
+        }
+        data_array = data_array.empty() ? std::move(rows) : merge_by_timestamp(data_array, rows, limit);
+    }
+
+    // 보존 기간이 지나 아카이브된 구간도 함께 조회
+    if (filter.has_time_range && log_archive.enabled()) {
+        json archived = log_archive.scan(config.all_logs_collection(), filter, limit);
+        if (!archived.empty()) {
+            data_array = merge_by_timestamp(data_array, archived, limit);
+        }
+    }
+    return data_array;
+}
+
+// 집계 결과의 숫자 필드 변환 ($sum 결과는 크기에 따라 int32/int64)
+static int64_t element_to_int64(const bsoncxx::document::element& element) {
+    switch (element.type()) {
+        case bsoncxx::type::k_int32: return element.get_int32().value;
+        case bsoncxx::type::k_int64: return element.get_int64().value;
+        case bsoncxx::type::k_double: return static_cast<int64_t>(element.get_double().value);
+        default: return 0;
+    }
+}
+
+mongocxx::collection& DatabaseManager::match_partitions(CollectionHandles& handles,
+                                                       mongocxx::pipeline& pipeline,
+                                                       const bsoncxx::document::view& match,
+                                                       bool has_range, int64_t start_time, int64_t end_time) {
+    auto names = partitions.select(has_range, start_time, end_time);
+    if (names.empty()) names.push_back(partitions.collection_for(end_time));
+
+    pipeline.match(match);
+    for (size_t i = 1; i < names.size(); ++i) {
+        pipeline.append_stage(bson_builder{}
+            << "$unionWith" << bsoncxx::builder::stream::open_document
+                << "coll" << names[i]
+                << "pipeline" << bsoncxx::builder::stream::open_array
+                    << bsoncxx::builder::stream::open_document << "$match" << bsoncxx::types::b_document{match}
+                    << bsoncxx::builder::stream::close_document
+                << bsoncxx::builder::stream::close_array
+            << bsoncxx::builder::stream::close_document << finalize);
     }
-    return "MEDIUM"; // 기본값
+    return handles.collection(names.front());
 }
 
-void DatabaseManager::process_query_request(mongocxx::client& mongo_client, 
+json DatabaseManager::aggregate_logs(CollectionHandles& handles,
+                                     const std::string& query_type,
+                                     LogFilter filter,
+                                     const json& query) {
+    using bsoncxx::builder::stream::open_document;
+    using bsoncxx::builder::stream::close_document;
+    using bsoncxx::builder::stream::open_array;
+    using bsoncxx::builder::stream::close_array;
+
+    // top_devices는 레벨/심각도 조건이 없으면 에러 로그 기준으로 집계
+    if (query_type == "top_devices" && filter.log_level.empty() && filter.severity.empty()) {
+        filter.log_level = "error";
+    }
+
+    auto match = filter.to_bson();
+    mongocxx::pipeline pipeline{};
+    auto& collection = match_partitions(handles, pipeline, match.view(),
+                                        filter.has_time_range, filter.start_time, filter.end_time);
+
+    json data_array = json::array();
+
+    if (query_type == "count") {
+        // severity / log_code / device_id 별 개수
+        std::string group_by = query.value("group_by", "severity");
+        if (group_by != "severity" && group_by != "log_code" && group_by != "device_id") {
+            throw std::invalid_argument("Unsupported group_by: " + group_by);
+        }
+
+        pipeline.group(bson_builder{} << "_id" << ("$" + group_by)
+                                      << "count" << open_document << "$sum" << 1 << close_document
+                                      << finalize);
+        pipeline.sort(bson_builder{} << "count" << -1 << finalize);
+
+        for (auto&& doc : collection.aggregate(pipeline)) {
+            json row;
+            row["key"] = doc["_id"].type() == bsoncxx::type::k_string
+                             ? std::string(doc["_id"].get_string().value) : "unknown";
+            row["count"] = element_to_int64(doc["count"]);
+            data_array.push_back(row);
+        }
+    } else if (query_type == "histogram") {
+        // bucket_ms 단위 시간 구간별 개수
+        int64_t bucket_ms = query.value("bucket_ms", int64_t{60000});
+        if (bucket_ms <= 0) {
+            throw std::invalid_argument("bucket_ms must be positive");
+        }
+
+        pipeline.group(bson_builder{} << "_id" << open_document
+                                          << "$subtract" << open_array
+                                              << "$timestamp"
+                                              << open_document << "$mod" << open_array
+                                                  << "$timestamp" << bsoncxx::types::b_int64{bucket_ms}
+                                              << close_array << close_document
+                                          << close_array
+                                      << close_document
+                                      << "count" << open_document << "$sum" << 1 << close_document
+                                      << finalize);
+        pipeline.sort(bson_builder{} << "_id" << 1 << finalize);
+
+        for (auto&& doc : collection.aggregate(pipeline)) {
+            json row;
+            row["start"] = element_to_int64(doc["_id"]);
+            row["count"] = element_to_int64(doc["count"]);
+            data_array.push_back(row);
+        }
+    } else if (query_type == "top_devices") {
+        // 에러 개수 상위 N개 디바이스
+        int limit = std::clamp(query.value("limit", 10), 1, 1000);
+
+        pipeline.group(bson_builder{} << "_id" << "$device_id"
+                                      << "device_name" << open_document << "$first" << "$device_name" << close_document
+                                      << "count" << open_document << "$sum" << 1 << close_document
+                                      << finalize);
+        pipeline.sort(bson_builder{} << "count" << -1 << finalize);
+        pipeline.limit(limit);
+
+        for (auto&& doc : collection.aggregate(pipeline)) {
+            if (doc["_id"].type() != bsoncxx::type::k_string) continue;
+            json row;
+            row["device_id"] = std::string(doc["_id"].get_string().value);
+            if (doc["device_name"] && doc["device_name"].type() == bsoncxx::type::k_string) {
+                row["device_name"] = std::string(doc["device_name"].get_string().value);
+            }
+            row["count"] = element_to_int64(doc["count"]);
+            data_array.push_back(row);
+        }
+    }
+
+    return data_array;
+}
+
+void DatabaseManager::process_query_request(CollectionHandles& handles, 
                                           mqtt::async_client* mqtt_client, 
                                           const json& query) {
+    Tracer::Trace trace(tracer, "query");
     try {
         std::string query_id = query.value("query_id", "");
         std::string query_type = query.value("query_type", "");
+
+        // 시간 창 내 같은 query_id 재수신 (QoS 1 재전송) 무시
+        if (!query_id.empty() && request_dedup.seen("query|" + query_id)) {
+            std::cout << "Duplicate query detected (ID: " << query_id << "). Ignoring." << std::endl;
+            return;
+        }
+
+        // 구독 lease 연장 / 해지는 DB 조회 없이 처리
+        if (query_type == "renew" || query_type == "unsubscribe") {
+            process_subscription_control(mqtt_client, query);
+            return;
+        }
+
+        if (query_type == "metrics") {
+            process_metrics_request(mqtt_client, query);
+            return;
+        }
+
+        if (query_type == "device_states") {
+            process_device_states_request(mqtt_client, query);
+            return;
+        }
         
-        if (query_type != "logs") {
+        // 응답 인코딩 (캐시 / 진행 중 조회 공유는 인코딩별로 따로 두어 인코딩된 본문을 그대로 재사용)
+        ResponseEncoder::Encoding encoding = ResponseEncoder::parse(query);
+
+        bool is_aggregate = query_type == "count" || query_type == "histogram" || query_type == "top_devices";
+        if (query_type != "logs" && query_type != "subscribe" && !is_aggregate) {
             json error_response;
             error_response["query_id"] = query_id;
             error_response["status"] = "error";
@@ -107,98 +267,122 @@ void DatabaseManager::process_query_request(mongocxx::client& mongo_client,
             return;
         }
         
-        // 새로운 MongoDB 클라이언트 생성으로 최신 데이터 보장
-        mongocxx::client fresh_client{mongocxx::uri{config.mongo_uri()}};
-        auto db = fresh_client[config.mongo_db_name()];
-        auto collection = db[config.all_logs_collection()];
-        
-        std::cout << "Processing query with fresh MongoDB connection..." << std::endl;
-        
         // 필터 빌드
-        using bsoncxx::builder::stream::document;
-        using bsoncxx::builder::stream::finalize;
-        
-        auto filter_builder = document{};
-        
-        if (query.contains("filters")) {
-            auto filters = query["filters"];
-            
-            if (filters.contains("device_id") && !filters["device_id"].empty()) {
-                filter_builder << "device_id" << filters["device_id"].get<std::string>();
-            }
-            
-            if (filters.contains("log_level") && !filters["log_level"].empty()) {
-                filter_builder << "log_level" << filters["log_level"].get<std::string>();
-            }
-            
-            if (filters.contains("log_code") && !filters["log_code"].empty()) {
-                filter_builder << "log_code" << filters["log_code"].get<std::string>();
-            }
-            
-            if (filters.contains("severity") && !filters["severity"].empty()) {
-                filter_builder << "severity" << filters["severity"].get<std::string>();
+        json filters = query.value("filters", json::object());
+        LogFilter filter = LogFilter::from_json(filters);
+
+        // 동일한 조회는 캐시된 응답으로 처리 (DB 조회 생략)
+        // 키는 query_id를 제외한 정규화된 요청 (json 객체는 키 정렬 상태로 직렬화됨)
+        std::string cache_key;
+        if (query_type != "subscribe") {
+            json normalized = query;
+            normalized.erase("query_id");
+            if (encoding.identity()) normalized.erase("encoding");
+            else normalized["encoding"] = encoding.name();
+            cache_key = normalized.dump();
+            std::string cached;
+            if (query_cache.get(cache_key, cached)) {
+                std::string payload = with_query_id(cached, query_id);
+                mqtt_client->publish(config.query_response_topic(), payload.c_str(), payload.length(), 1, false);
+                std::cout << "Query served from cache: " << query_id << std::endl;
+                return;
             }
-            
-            if (filters.contains("time_range")) {
-                auto time_range = filters["time_range"];
-                if (time_range.contains("start") && time_range.contains("end")) {
-                    int64_t start_time = time_range["start"];
-                    int64_t end_time = time_range["end"];
-                    
-                    filter_builder << "timestamp" << bsoncxx::builder::stream::open_document
-                                  << "$gte" << bsoncxx::types::b_int64{start_time}
-                                  << "$lte" << bsoncxx::types::b_int64{end_time}
-                                  << bsoncxx::builder::stream::close_document;
+        }
+
+        // 조회 전 캐시 세대 (조회 중 해당 로그가 저장되면 결과를 캐시하지 않음)
+        QueryCache::Tags cache_tags{filter.device_id, filter.log_code};
+        uint64_t cache_generation = query_cache.generation(cache_tags);
+
+        // 같은 조회가 처리 중이면 그 결과를 공유 (subscribe는 요청마다 구독을 만들어야 하므로 제외)
+        RequestDeduplicator::Ticket ticket;
+        if (!cache_key.empty()) {
+            ticket = request_dedup.join(cache_key);
+            if (!ticket.leader) {
+                std::string body = ticket.result.get();
+                if (body.empty()) {
+                    throw std::runtime_error("Coalesced query failed");
                 }
+                std::string payload = with_query_id(body, query_id);
+                mqtt_client->publish(config.query_response_topic(), payload.c_str(), payload.length(), 1, false);
+                std::cout << "Query coalesced with in-flight request: " << query_id << std::endl;
+                return;
             }
         }
-        
-        auto filter = filter_builder << finalize;
+        RequestDeduplicator::Completion completion(request_dedup, ticket, cache_key);
         
         // 제한 설정
         int limit = 100; // 기본값
-        if (query.contains("filters") && query["filters"].contains("limit")) {
-            limit = query["filters"]["limit"];
+        if (filters.contains("limit")) {
+            limit = filters["limit"];
         }
         
-        // 쿼리 실행
-        mongocxx::options::find opts{};
-        opts.limit(limit);
-        opts.sort(document{} << "timestamp" << -1 << finalize); // 최신순 정렬
-        
-        auto cursor = collection.find(filter.view(), opts);
-        
-        // 결과 수집
         json response;
-        response["query_id"] = query_id;
         response["status"] = "success";
+
+        // 집계 조회는 결과 행 대신 요약 결과만 전송
+        if (is_aggregate) {
+            json data_array;
+            {
+                Tracer::Span span(Tracer::QUERY);
+                data_array = aggregate_logs(handles, query_type, filter, query);
+            }
+            size_t row_count = data_array.size();
+            response["query_type"] = query_type;
+            response["count"] = row_count;
+            response["data"] = std::move(data_array);
+
+            std::string body = response_encoder.encode(encoding, std::move(response));
+            query_cache.put(cache_key, body, cache_tags, cache_generation);
+            completion.set(body);
+
+            std::string payload = with_query_id(body, query_id);
+            mqtt_client->publish(config.query_response_topic(), payload.c_str(), payload.length(), 1, false);
+            std::cout << "Aggregate query processed: " << query_id << " (" << query_type << ", "
+                      << row_count << " rows)" << std::endl;
+            return;
+        }
+
+        // 구독 등록은 초기 조회보다 먼저 수행 (조회 중 들어온 로그 누락 방지)
+        if (query_type == "subscribe") {
+            SubscriptionManager::Subscription sub;
+            if (!subscriptions.subscribe(generate_ulid(), filter, query.value("lease_ms", int64_t{0}), sub)) {
+                json error_response;
+                error_response["query_id"] = query_id;
+                error_response["status"] = "error";
+                error_response["error"] = "Subscription limit reached";
+                std::string payload = error_response.dump();
+                mqtt_client->publish(config.query_response_topic(), payload.c_str(), payload.length(), 1, false);
+                return;
+            }
+            response["subscription_id"] = sub.id;
+            response["topic"] = sub.topic;
+            response["lease_ms"] = sub.lease_ms;
+            std::cout << "Subscription registered: " << sub.id << " -> " << sub.topic << std::endl;
+        }
         
-        json data_array = json::array();
-        int count = 0;
-        
-        for (auto&& doc : cursor) {
-            json log_item;
-            auto view = doc;
-            
-            if (view["_id"]) log_item["_id"] = std::string(view["_id"].get_string().value);
-            if (view["device_id"]) log_item["device_id"] = std::string(view["device_id"].get_string().value);
-            if (view["device_name"]) log_item["device_name"] = std::string(view["device_name"].get_string().value);
-            if (view["log_level"]) log_item["log_level"] = std::string(view["log_level"].get_string().value);
-            if (view["log_code"]) log_item["log_code"] = std::string(view["log_code"].get_string().value);
-            if (view["severity"]) log_item["severity"] = std::string(view["severity"].get_string().value);
-            if (view["message"]) log_item["message"] = std::string(view["message"].get_string().value);
-            if (view["location"]) log_item["location"] = std::string(view["location"].get_string().value);
-            if (view["timestamp"]) log_item["timestamp"] = view["timestamp"].get_int64().value;
-            
-            data_array.push_back(log_item);
-            count++;
+        // 쿼리 실행 및 결과 수집
+        // 최근 구간은 메모리 컬럼 저장소에서 처리하고, 결과가 보장되지 않을 때만 MongoDB 조회
+        bool complete = false;
+        json data_array = hot_store.find(filter, limit, complete);
+        if (complete) {
+            std::cout << "Query served from hot store: " << query_id << std::endl;
+        } else {
+            Tracer::Span span(Tracer::QUERY);
+            data_array = find_logs(handles, filter, limit);
         }
+        int count = static_cast<int>(data_array.size());
         
         response["count"] = count;
-        response["data"] = data_array;
+        response["data"] = std::move(data_array);
+
+        std::string body = response_encoder.encode(encoding, std::move(response));
+        if (!cache_key.empty()) {
+            query_cache.put(cache_key, body, cache_tags, cache_generation);
+            completion.set(body);
+        }
         
         // 응답 전송
-        std::string payload = response.dump();
+        std::string payload = with_query_id(body, query_id);
         mqtt_client->publish(config.query_response_topic(), payload.c_str(), payload.length(), 1, false);
         
         std::cout << "Query processed: " << query_id << " (" << count << " results)" << std::endl;
@@ -215,9 +399,228 @@ void DatabaseManager::process_query_request(mongocxx::client& mongo_client,
     }
 }
 
-void DatabaseManager::process_statistics_request(mongocxx::client& mongo_client,
+void DatabaseManager::process_metrics_request(mqtt::async_client* mqtt_client, const json& query) {
+    json response;
+    response["query_id"] = query.value("query_id", "");
+    response["status"] = "success";
+    response["metrics"]["query_cache"] = query_cache.stats();
+    response["metrics"]["subscriptions"]["active"] = subscriptions.size();
+    response["metrics"]["hot_store"] = hot_store.stats();
+    response["metrics"]["sketches"] = sketches.stats();
+    response["metrics"]["device_cache"] = device_cache.stats();
+    response["metrics"]["request_dedup"] = request_dedup.stats();
+    response["metrics"]["ingest_policy"] = ingest_policy.stats();
+    response["metrics"]["snapshot"] = snapshots.stats();
+    response["metrics"]["tracing"] = tracer.stats();
+    response["metrics"]["log_writer"] = log_writer.stats();
+    response["metrics"]["partitions"] = partitions.stats();
+    response["metrics"]["event_time"] = event_clock.stats();
+    response["metrics"]["alarms"] = alarms.stats();
+    response["metrics"]["response_encoding"] = response_encoder.stats();
+    response["metrics"]["device_state_persist"] = state_persister.stats();
+    response["metrics"]["statistics_fanout"] = {{"devices", last_fanout_devices.load()},
+                                                {"latency_ms", last_fanout_ms.load()}};
+
+    std::string payload = response.dump();
+    mqtt_client->publish(config.query_response_topic(), payload.c_str(), payload.length(), 1, false);
+}
+
+void DatabaseManager::process_device_states_request(mqtt::async_client* mqtt_client, const json& query) {
+    json response;
+    response["query_id"] = query.value("query_id", "");
+    response["status"] = "success";
+
+    // device_id 지정 시 단일 디바이스, 없으면 전체 디바이스 스냅샷
+    std::string device_id;
+    if (query.contains("filters") && query["filters"].contains("device_id")) {
+        device_id = query["filters"]["device_id"].get<std::string>();
+    }
+
+    json data_array = json::array();
+    if (device_id.empty()) {
+        data_array = device_states.snapshot();
+    } else {
+        json state;
+        if (device_states.device_json(device_id, state)) {
+            data_array.push_back(state);
+        }
+    }
+    response["count"] = data_array.size();
+    response["data"] = data_array;
+
+    std::string payload = response.dump();
+    mqtt_client->publish(config.query_response_topic(), payload.c_str(), payload.length(), 1, false);
+    std::cout << "Device states processed: " << data_array.size() << " devices" << std::endl;
+}
+
+void DatabaseManager::load_device_states(mongocxx::client& mongo_client) {
+    if (!config.device_state_persist()) return;
+
+    try {
+        auto db = mongo_client[config.mongo_db_name()];
+        auto cursor = db[config.device_state_collection()].find({});
+        for (auto&& doc : cursor) {
+            device_states.restore(json::parse(bsoncxx::to_json(doc)));
+        }
+        std::cout << "Loaded latest state for " << device_states.size() << " devices" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading device states: " << e.what() << std::endl;
+    }
+}
+
+void DatabaseManager::process_subscription_control(mqtt::async_client* mqtt_client, const json& query) {
+    std::string query_type = query.value("query_type", "");
+    std::string subscription_id = query.value("subscription_id", "");
+
+    json response;
+    response["query_id"] = query.value("query_id", "");
+    response["subscription_id"] = subscription_id;
+
+    bool found = false;
+    if (query_type == "renew") {
+        SubscriptionManager::Subscription sub;
+        found = subscriptions.renew(subscription_id, query.value("lease_ms", int64_t{0}), sub);
+        if (found) response["lease_ms"] = sub.lease_ms;
+    } else {
+        found = subscriptions.unsubscribe(subscription_id);
+    }
+
+    if (found) {
+        response["status"] = "success";
+    } else {
+        response["status"] = "error";
+        response["error"] = "Subscription not found";
+    }
+
+    std::string payload = response.dump();
+    mqtt_client->publish(config.query_response_topic(), payload.c_str(), payload.length(), 1, false);
+
+    std::cout << "Subscription " << query_type << ": " << subscription_id
+              << (found ? " (ok)" : " (not found)") << std::endl;
+}
+
+void DatabaseManager::publish_to_subscribers(mqtt::async_client* mqtt_client,
+                                           const bsoncxx::document::view& log_doc,
+                                           const std::string& device_id,
+                                           const std::string& log_level,
+                                           const std::string& log_code,
+                                           const std::string& severity,
+                                           int64_t timestamp) {
+    if (!mqtt_client || subscriptions.empty()) return;
+
+    auto targets = subscriptions.match(device_id, log_level, log_code, severity, timestamp);
+    if (targets.empty()) return;
+    Tracer::Span span(Tracer::PUBLISH);
+
+    json log_item = log_document_to_json(log_doc);
+    for (const auto& target : targets) {
+        json push;
+        push["subscription_id"] = target.subscription_id;
+        push["data"] = json::array({log_item});
+        std::string payload = push.dump();
+        mqtt_client->publish(target.topic, payload.c_str(), payload.length(), 1, false);
+    }
+    std::cout << "✓ Pushed to " << targets.size() << " subscription(s)" << std::endl;
+}
+
+std::vector<std::string> DatabaseManager::numeric_device_ids(CollectionHandles& handles) {
+    using bsoncxx::builder::stream::open_document;
+    using bsoncxx::builder::stream::close_document;
+
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::lock_guard<std::mutex> lock(numeric_devices_mutex);
+    if (numeric_devices_loaded_at == 0 || now - numeric_devices_loaded_at >= config.device_cache_ttl_sec() * 1000) {
+        // 전체 로그에서 숫자 메시지가 있는 디바이스 ID (기존 distinct와 같은 조건)
+        auto match = bson_builder{} << "message" << open_document << "$regex" << "^[0-9]+$" << close_document
+                                    << finalize;
+        mongocxx::pipeline pipeline{};
+        auto& collection = match_partitions(handles, pipeline, match.view(), false, 0, 0);
+        pipeline.group(bson_builder{} << "_id" << "$device_id" << finalize);
+
+        std::set<std::string> loaded;
+        for (auto&& doc : collection.aggregate(pipeline)) {
+            if (doc["_id"] && doc["_id"].type() == bsoncxx::type::k_string) {
+                loaded.emplace(doc["_id"].get_string().value);
+            }
+        }
+        numeric_devices.swap(loaded);
+        numeric_devices_loaded_at = now;
+    }
+
+    // 마지막 조회 이후 숫자 메시지를 처음 보낸 디바이스도 포함
+    for (auto& id : device_states.numeric_device_ids()) numeric_devices.insert(std::move(id));
+    return std::vector<std::string>(numeric_devices.begin(), numeric_devices.end());
+}
+
+std::unordered_map<std::string, DatabaseManager::SpeedStats> DatabaseManager::speed_statistics(
+        CollectionHandles& handles, const std::string& device_id, int64_t start_time, int64_t end_time) {
+    using bsoncxx::builder::stream::open_document;
+    using bsoncxx::builder::stream::close_document;
+    using bsoncxx::builder::stream::open_array;
+    using bsoncxx::builder::stream::close_array;
+
+    // 숫자 메시지 로그만 (device_id가 비어 있으면 전체 디바이스)
+    bson_builder match;
+    if (!device_id.empty()) {
+        match << "device_id" << device_id;
+    }
+    match << "timestamp" << open_document
+          << "$gte" << bsoncxx::types::b_int64{start_time}
+          << "$lte" << bsoncxx::types::b_int64{end_time}
+          << close_document
+          << "message" << open_document << "$regex" << "^[0-9]+$" << close_document;
+
+    auto match_doc = match << finalize;
+    mongocxx::pipeline pipeline{};
+    auto& collection = match_partitions(handles, pipeline, match_doc.view(), true, start_time, end_time);
+    pipeline.add_fields(bson_builder{} << "speed_value" << open_document << "$toDouble" << "$message" << close_document
+                                       << finalize);
+
+    // 평균은 0보다 큰 값만, 현재 속도는 범위 내 최신 로그 ({timestamp, value} 최대값)
+    pipeline.group(bson_builder{} << "_id" << "$device_id"
+                                  << "positive_sum" << open_document << "$sum" << open_document
+                                      << "$cond" << open_array
+                                          << open_document << "$gt" << open_array << "$speed_value" << 0 << close_array << close_document
+                                          << "$speed_value" << 0
+                                      << close_array
+                                  << close_document << close_document
+                                  << "positive_count" << open_document << "$sum" << open_document
+                                      << "$cond" << open_array
+                                          << open_document << "$gt" << open_array << "$speed_value" << 0 << close_array << close_document
+                                          << 1 << 0
+                                      << close_array
+                                  << close_document << close_document
+                                  << "latest" << open_document << "$max" << open_document
+                                      << "timestamp" << "$timestamp"
+                                      << "value" << "$speed_value"
+                                  << close_document << close_document
+                                  << finalize);
+
+    std::unordered_map<std::string, SpeedStats> result;
+    for (auto&& doc : collection.aggregate(pipeline)) {
+        if (!doc["_id"] || doc["_id"].type() != bsoncxx::type::k_string) continue;
+
+        SpeedStats stats;
+        int64_t positive_count = element_to_int64(doc["positive_count"]);
+        if (positive_count > 0 && doc["positive_sum"].type() == bsoncxx::type::k_double) {
+            stats.average = doc["positive_sum"].get_double() / positive_count;
+        }
+        if (doc["latest"] && doc["latest"].type() == bsoncxx::type::k_document) {
+            auto latest_value = doc["latest"].get_document().view()["value"];
+            if (latest_value && latest_value.type() == bsoncxx::type::k_double) {
+                stats.current_speed = static_cast<int>(latest_value.get_double());
+            }
+        }
+        result[std::string(doc["_id"].get_string().value)] = stats;
+    }
+    return result;
+}
+
+void DatabaseManager::process_statistics_request(CollectionHandles& handles,
                                                  mqtt::async_client* mqtt_client,
                                                  const json& request) {
+    Tracer::Trace trace(tracer, "statistics");
     std::cout << "Processing statistics request: " << request.dump() << std::endl;
     
     // 디바이스 ID 확인
@@ -227,24 +630,14 @@ void DatabaseManager::process_statistics_request(mongocxx::client& mongo_client,
         return;
     }
 
-    // 요청 ID 확인 (중복 요청 방지)
-    static std::string last_request_id = "";
+    // 요청 ID 확인 (시간 창 내 중복 요청 방지)
     std::string request_id = request.value("request_id", "");
-    
-    if (!request_id.empty() && request_id == last_request_id) {
+    if (!request_id.empty() && request_dedup.seen("statistics|" + request_id)) {
         std::cout << "Duplicate request detected (ID: " << request_id << "). Ignoring." << std::endl;
         return;
     }
-    
-    // 새 요청 ID 저장
-    if (!request_id.empty()) {
-        last_request_id = request_id;
-    }
 
     try {
-        auto db = mongo_client[config.mongo_db_name()];
-        auto collection = db[config.all_logs_collection()];
-
         // 시간 범위 설정
         int64_t start_time = 0, end_time = 0;
         if (request.contains("time_range") && 
@@ -262,154 +655,111 @@ void DatabaseManager::process_statistics_request(mongocxx::client& mongo_client,
             std::cout << "Using default time range: " << start_time << " to " << end_time << std::endl;
         }
 
-        // 통계 계산 및 응답 전송 함수
-        auto calculate_and_publish = [&](const std::string& dev_id) {
-            // 디바이스 기반 로그 필터링 (숫자 메시지만)
-            bson_builder filter_builder;
-            filter_builder << "device_id" << dev_id
-                          << "timestamp" << bsoncxx::builder::stream::open_document
-                          << "$gte" << bsoncxx::types::b_int64{start_time}
-                          << "$lte" << bsoncxx::types::b_int64{end_time}
-                          << bsoncxx::builder::stream::close_document
-                          << "message" << bsoncxx::builder::stream::open_document
-                          << "$regex" << "^[0-9]+$"
-                          << bsoncxx::builder::stream::close_document;
-
-            // 숫자 메시지 로그 개수 확인
-            auto count = collection.count_documents(filter_builder.view());
-            std::cout << "Found " << count << " numeric logs for device " << dev_id << std::endl;
-            
-            if (count == 0) {
-                std::cout << "No numeric logs found for device " << dev_id << ". Checking for any logs..." << std::endl;
-                
-                // 디바이스 자체가 존재하는지 확인
-                bson_builder device_filter;
-                device_filter << "device_id" << dev_id;
-                auto device_count = collection.count_documents(device_filter.view());
-                
-                if (device_count == 0) {
-                    std::cout << "No logs found for device " << dev_id << ". Device might not exist." << std::endl;
-                } else {
-                    std::cout << "Device " << dev_id << " exists with " << device_count << " logs, but no numeric logs." << std::endl;
-                }
+        // 같은 디바이스/시간 범위 요청이 처리 중이면 그 결과를 받아 request_id만 바꿔 전송
+        std::string coalesce_key = "statistics|" + device_id + "|" + std::to_string(start_time) + "|" + std::to_string(end_time);
+        auto ticket = request_dedup.join(coalesce_key);
+        if (!ticket.leader) {
+            std::string shared = ticket.result.get();
+            if (shared.empty()) {
+                throw std::runtime_error("Coalesced statistics request failed");
             }
-
-            // 평균 속도 계산 (MongoDB Aggregation 사용)
-            mongocxx::pipeline pipeline{};
-            pipeline.match(filter_builder.view());
-            
-            // 메시지 필드 확인 (디버깅)
-            auto sample_doc = collection.find_one(filter_builder.view());
-            if (sample_doc) {
-                auto doc_view = sample_doc->view();
-                if (doc_view["message"]) {
-                    std::string message_str(doc_view["message"].get_string().value);
-                    std::cout << "Sample numeric message: '" << message_str << "'" << std::endl;
-                }
-            }
-            
-            // 문자열을 숫자로 변환
-            pipeline.add_fields(bson_builder{} << "speed_value" << bsoncxx::builder::stream::open_document
-                                             << "$toDouble" << "$message"
-                                             << bsoncxx::builder::stream::close_document
-                                             << finalize);
-
-            // 0보다 큰 값만 필터링 (속도가 0인 경우 평균 계산에서 제외)
-            pipeline.match(bson_builder{} << "speed_value" << bsoncxx::builder::stream::open_document
-                                        << "$gt" << 0.0
-                                        << bsoncxx::builder::stream::close_document
-                                        << finalize);
-                                        
-            // 평균 계산
-            pipeline.group(bson_builder{} << "_id" << bsoncxx::types::b_null{}
-                                        << "average" << bsoncxx::builder::stream::open_document
-                                        << "$avg" << "$speed_value"
-                                        << bsoncxx::builder::stream::close_document
-                                        << finalize);
-
-            // 평균 속도 추출
-            double average_speed = 0.0;
-            auto cursor = collection.aggregate(pipeline);
-            bool has_results = false;
-            
-            for (auto&& doc : cursor) {
-                has_results = true;
-                if (doc["average"] && doc["average"].type() == bsoncxx::type::k_double) {
-                    average_speed = doc["average"].get_double();
-                    std::cout << "Calculated average speed: " << average_speed << std::endl;
-                    break;
+            for (auto& item : json::parse(shared)) {
+                json response = item["response"];
+                if (!request_id.empty()) {
+                    response["request_id"] = request_id;
                 }
+                std::string payload = response.dump();
+                mqtt_client->publish(item["topic"].get<std::string>(), payload.c_str(), payload.length(), 1, false);
             }
-            
-            if (!has_results) {
-                std::cout << "No valid numeric logs found for average calculation" << std::endl;
-            }
-
-            // 현재 속도 조회 (최신 숫자 로그)
-            int current_speed = 0;
-            mongocxx::options::find opts{};
-            opts.sort(bson_builder{} << "timestamp" << -1 << finalize); // 최신순 정렬
-            opts.limit(1); // 가장 최근 1개만
+            std::cout << "Statistics request coalesced with in-flight request: " << coalesce_key << std::endl;
+            return;
+        }
+        RequestDeduplicator::Completion completion(request_dedup, ticket, coalesce_key);
+        json published = json::array();
 
-            auto latest_doc = collection.find_one(filter_builder.view(), opts);
-            if (latest_doc) {
-                try {
-                    auto doc_view = latest_doc->view();
-                    if (doc_view["message"]) {
-                        std::string message_str(doc_view["message"].get_string().value);
-                        current_speed = std::stoi(message_str);
-                        std::cout << "Current speed from latest log: " << current_speed << std::endl;
-                    }
-                } catch (const std::exception& e) {
-                    std::cerr << "Error parsing current_speed: " << e.what() << std::endl;
-                }
-            } else {
-                std::cout << "No valid numeric logs found for current speed" << std::endl;
+        // 통계 응답 생성 및 전송 (전송 완료를 기다리지 않음)
+        auto publish_statistics = [&](const std::string& dev_id, const SpeedStats& stats) {
+            // 최신 상태 테이블의 숫자 값이 요청 범위 안이면 범위 내 최신 로그이므로 그 값을 사용
+            // (기록 대기 중이거나 저장 정책으로 저장되지 않은 값도 반영)
+            int current_speed = stats.current_speed;
+            DeviceStateTable::LatestValue latest;
+            double latest_value = 0.0;
+            if (device_states.latest_numeric(dev_id, latest) &&
+                latest.timestamp >= start_time && latest.timestamp <= end_time &&
+                string_util::parse_numeric(latest.message, latest_value)) {
+                current_speed = static_cast<int>(latest_value);
             }
 
-            // 응답 생성
             json response;
             response["device_id"] = dev_id;
-            response["average"] = static_cast<int>(average_speed); // 정수로 변환
+            response["average"] = static_cast<int>(stats.average); // 정수로 변환
             response["current_speed"] = current_speed;
+
+            // 분위수/고유 에러 수 (스케치 보유 구간일 때만)
+            if (sketches.covers(start_time)) {
+                auto summary = sketches.summarize(dev_id, start_time, end_time);
+                auto percentiles = [](const DDSketch& sketch) {
+                    return json{{"p50", sketch.quantile(0.50)},
+                                {"p95", sketch.quantile(0.95)},
+                                {"p99", sketch.quantile(0.99)}};
+                };
+                if (!summary.speed.empty()) response["speed_percentiles"] = percentiles(summary.speed);
+                if (!summary.temperature.empty()) response["temperature_percentiles"] = percentiles(summary.temperature);
+                response["distinct_errors"] = summary.errors.estimate();
+            }
             if (!request_id.empty()) {
                 response["request_id"] = request_id;
             }
 
-            // 응답 전송
             std::string response_topic = "factory/" + dev_id + "/msg/statistics";
             std::string payload = response.dump();
             mqtt_client->publish(response_topic, payload.c_str(), payload.length(), 1, false);
-            
+            published.push_back({{"topic", response_topic}, {"response", response}});
+
             std::cout << "Published statistics for " << dev_id << ": " << payload << std::endl;
         };
 
+        // 최근 구간이면 메모리 컬럼 저장소에서 계산 (MongoDB 조회 생략)
+        bool from_hot_store = hot_store.covers(start_time);
+        auto hot_store_stats = [&](const std::string& dev_id) {
+            auto numeric = hot_store.numeric_stats(dev_id, start_time, end_time);
+            SpeedStats stats;
+            if (numeric.count > 0) stats.average = numeric.sum / numeric.count;
+            if (numeric.numeric > 0) stats.current_speed = static_cast<int>(numeric.latest_value);
+            return stats;
+        };
+
+        auto started = std::chrono::steady_clock::now();
+        Tracer::Span span(Tracer::STATISTICS);
+
         // 디바이스 ID에 따라 처리
         if (device_id == "All") {
-            // 모든 디바이스 ID 조회 (숫자 메시지가 있는 디바이스)
-            mongocxx::pipeline distinct_pipeline{};
-            distinct_pipeline.match(bson_builder{} << "message" << bsoncxx::builder::stream::open_document
-                                                 << "$regex" << "^[0-9]+$"
-                                                 << bsoncxx::builder::stream::close_document
-                                                 << finalize);
-            distinct_pipeline.group(bson_builder{} << "_id" << "$device_id" << finalize);
-            
-            auto distinct_cursor = collection.aggregate(distinct_pipeline);
-            int device_count = 0;
-            
-            for (auto&& doc : distinct_cursor) {
-                if (doc["_id"] && doc["_id"].type() == bsoncxx::type::k_string) {
-                    std::string id_str(doc["_id"].get_string().value);
-                    calculate_and_publish(id_str);
-                    device_count++;
-                }
+            // 대상은 숫자 메시지 로그가 있는 디바이스 (캐시), 통계는 디바이스별 $group 한 번으로 계산
+            // 범위 안에 데이터가 없는 디바이스도 0으로 응답
+            auto device_ids = numeric_device_ids(handles);
+            std::unordered_map<std::string, SpeedStats> all_stats;
+            if (!from_hot_store) {
+                all_stats = speed_statistics(handles, "", start_time, end_time);
             }
-            
-            std::cout << "Processed statistics for " << device_count << " devices" << std::endl;
+
+            for (const auto& id : device_ids) {
+                publish_statistics(id, from_hot_store ? hot_store_stats(id) : all_stats[id]);
+            }
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - started).count();
+            last_fanout_devices = device_ids.size();
+            last_fanout_ms = elapsed;
+            std::cout << "Processed statistics for " << device_ids.size() << " devices in " << elapsed << " ms ("
+                      << (from_hot_store ? "hot store" : "1 aggregation") << ")" << std::endl;
         } else {
             // 단일 디바이스 처리
-            calculate_and_publish(device_id);
+            SpeedStats stats = from_hot_store
+                ? hot_store_stats(device_id)
+                : speed_statistics(handles, device_id, start_time, end_time)[device_id];
+            publish_statistics(device_id, stats);
         }
+        completion.set(published.dump());
 
     } catch (const std::exception& e) {
         std::cerr << "Error processing statistics request: " << e.what() << std::endl;
@@ -431,89 +781,307 @@ void DatabaseManager::process_statistics_request(mongocxx::client& mongo_client,
 }
 
 
-void DatabaseManager::save_log_to_mongodb(mongocxx::database& db, 
+void DatabaseManager::save_log_to_mongodb(CollectionHandles& handles, 
                                         const std::string& device_id,
                                         const std::string& log_level,
                                         const json& payload,
                                         const std::string& topic,
-                                        const bsoncxx::document::view& device_info) {
+                                        const DeviceContext& device,
+                                        mqtt::async_client* mqtt_client) {
+    TelemetryRecord record;
+    try {
+        record = TelemetryRecord::from_json(payload);
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving log to MongoDB: " << e.what() << std::endl;
+        return;
+    }
+    save_log_to_mongodb(handles, device_id, log_level, record, topic, device, mqtt_client);
+}
+
+void DatabaseManager::save_log_to_mongodb(CollectionHandles& handles, 
+                                        const std::string& device_id,
+                                        const std::string& log_level,
+                                        const TelemetryRecord& record,
+                                        const std::string& topic,
+                                        const DeviceContext& device,
+                                        mqtt::async_client* mqtt_client) {
+    try {
+        save_log_batch(handles, device_id, log_level, {record}, topic, device, mqtt_client);
+    } catch (const std::exception& e) {
+        std::cerr << "Error saving log to MongoDB: " << e.what() << std::endl;
+    }
+}
+
+void DatabaseManager::save_log_batch(CollectionHandles& handles,
+                                     const std::string& device_id,
+                                     const std::string& log_level,
+                                     const std::vector<TelemetryRecord>& raw_records,
+                                     const std::string& topic,
+                                     const DeviceContext& device,
+                                     mqtt::async_client* mqtt_client) {
+    if (raw_records.empty()) return;
+
     try {
-        std::string log_code = payload.value("log_code", "UNKNOWN");
-        
         auto now = std::chrono::system_clock::now();
         auto ingestion_time = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-        
-        // 구조화된 ID 생성
-        std::string device_code = device_info["device_code"] ? std::string(device_info["device_code"].get_string().value) : "NA";
-        std::string ulid = generate_ulid();
-        std::string structured_id = device_code + "-" + log_code + "-" + ulid;
 
-        // log_stream 생성
-        time_t now_time_t = std::chrono::system_clock::to_time_t(now);
-        char time_buf[12];
-        strftime(time_buf, sizeof(time_buf), "%Y/%m/%d", std::gmtime(&now_time_t));
-        std::string log_stream = device_id + "/" + time_buf + "/" + log_level;
+        // 원본 값은 모두 메모리 통계(스케치, 최신 상태)에 반영하고,
+        // 저장 정책(deadband / interval / window)을 통과한 레코드만 MongoDB에 기록
+        // 모두 이벤트 시각(timestamp) 기준이므로 재전송된 과거 로그는 해당 구간에 반영됨
+        std::vector<TelemetryRecord> records;
+        std::vector<std::string> severities;
+        records.reserve(raw_records.size());
+        severities.reserve(raw_records.size());
+        std::vector<json> alarm_events;
+        for (const auto& raw : raw_records) {
+            int64_t timestamp = raw.has_timestamp ? raw.timestamp : ingestion_time;
+            if (event_clock.observe(device_id, timestamp, ingestion_time) == EventClock::Arrival::TOO_LATE) {
+                std::cout << "Late log beyond allowed lateness: " << device_id << " (" << raw.log_code
+                          << ", " << ingestion_time - timestamp << " ms behind)" << std::endl;
+            }
+            std::string severity;
+            {
+                Tracer::Span span(Tracer::SEVERITY);
+                severity = device.severity_rules.evaluate(raw.log_code, raw.metadata);
+            }
+
+            sketches.record(device_id, log_level, raw.log_code, raw.message, raw.metadata, timestamp);
+            device_states.update_log(device_id, raw.log_code, log_level, severity,
+                                     raw.message, timestamp, ingestion_time);
 
-        // Severity 계산
-        std::string severity = determine_severity(log_code, payload.value("metadata", json::object()), device_info);
+            alarms.evaluate(device_id, raw, timestamp, device.severity_rules, severity, alarm_events);
+            hot_store.record_sample(device_id, raw.message, timestamp);
+            ingest_policy.apply(device_id, log_level, raw, timestamp, event_clock.watermark(device_id), records);
 
-        // BSON 문서 빌드
-        bson_builder builder;
-        builder << "_id" << structured_id
-                << "log_group" << (device_info["log_group"] ? std::string(device_info["log_group"].get_string().value) : "unknown_group")
-                << "log_stream" << log_stream
-                << "device_id" << device_id
-                << "device_name" << (device_info["device_name"] ? std::string(device_info["device_name"].get_string().value) : "N/A")
-                << "device_type" << (device_info["device_type"] ? std::string(device_info["device_type"].get_string().value) : "N/A")
-                << "location" << (device_info["location"] ? std::string(device_info["location"].get_string().value) : "N/A")
-                << "log_code" << log_code
-                << "severity" << severity
-                << "log_level" << log_level
-                << "message" << payload.value("message", "")
-                << "timestamp" << bsoncxx::types::b_int64{payload.value("timestamp", ingestion_time)}
-                << "ingestion_time" << bsoncxx::types::b_int64{ingestion_time}
-                << "topic" << topic;
-
-        if (payload.contains("metadata") && payload["metadata"].is_object()) {
-            builder << "metadata" << bsoncxx::from_json(payload["metadata"].dump());
-        }
-
-        auto doc_to_insert = builder.extract();
-
-        // MongoDB에 데이터 삽입
-        std::cout << "\n=== Saving Log Document ===" << std::endl;
-        std::cout << "Structured ID: " << structured_id << std::endl;
-        std::cout << "Device: " << device_id << " (" << device_code << ")" << std::endl;
-        std::cout << "Log Code: " << log_code << " | Severity: " << severity << std::endl;
-        std::cout << "Message: " << payload.value("message", "") << std::endl;
-        std::cout << "Log Stream: " << log_stream << std::endl;
-        
-        // 그룹별 전용 컬렉션에 삽입
-        if (device_info["log_group"]) {
-            std::string group_str = std::string(device_info["log_group"].get_string().value);
-            std::replace(group_str.begin(), group_str.end(), '/', '_');
-            std::replace(group_str.begin(), group_str.end(), '-', '_');
-            if (!group_str.empty() && group_str.front() == '_') {
-                group_str.erase(0, 1);
+            // 원본 그대로 저장되는 레코드는 위에서 계산한 심각도를 사용하고, window 집계 레코드만 새로 계산
+            for (size_t i = severities.size(); i < records.size(); ++i) {
+                severities.push_back(is_aggregate_record(records[i])
+                    ? device.severity_rules.evaluate(records[i].log_code, records[i].metadata) : severity);
             }
-            std::string group_collection_name = "logs_" + group_str;
-            db[group_collection_name].insert_one(doc_to_insert.view());
-            std::cout << "✓ Saved to group collection: " << group_collection_name << std::endl;
         }
 
-        // logs_all 컬렉션에 삽입
-        db[config.all_logs_collection()].insert_one(doc_to_insert.view());
-        std::cout << "✓ Saved to " << config.all_logs_collection() << " collection" << std::endl;
-        std::cout << "=========================\n" << std::endl;
+        // 알람은 DB 기록 전에 바로 발행 (상태가 바뀐 경우만)
+        // 규칙 재적재로 삭제된 알람의 해제 이벤트는 다른 디바이스 것일 수 있으므로 이벤트의 device_id로 발행
+        if (mqtt_client && !alarm_events.empty()) {
+            for (const auto& event : alarm_events) {
+                std::string payload = event.dump();
+                try {
+                    mqtt_client->publish("factory/" + event["device_id"].get<std::string>() + "/alarm",
+                                         payload.c_str(), payload.length(), 1, false);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error publishing alarm: " << e.what() << std::endl;
+                }
+                std::cout << "Alarm " << event["state"].get<std::string>() << ": " << event["alarm_id"].get<std::string>()
+                          << " (value " << event["value"] << ")" << std::endl;
+            }
+        }
+
+        // 규칙 재적재로 닫힌 다른 스트림의 집계 구간도 함께 저장
+        auto retired = ingest_policy.take_retired();
+        if (!retired.empty()) {
+            auto flushed = write_pending(handles, std::move(retired), mqtt_client);
+            std::cout << "Closed windows after ingest policy reload: " << flushed.flushed << " saved, "
+                      << flushed.abandoned << " abandoned" << std::endl;
+        }
+
+        if (records.empty()) {
+            state_persister.mark(device_id);
+            std::cout << "Suppressed by ingest policy: " << device_id << " (" << raw_records.size() << " readings)" << std::endl;
+            return;
+        }
+
+        write_log_records(handles, device_id, log_level, records, severities, topic, device, mqtt_client, now);
 
     } catch (const std::exception& e) {
         std::cerr << "Error saving log to MongoDB: " << e.what() << std::endl;
     }
 }
 
-void DatabaseManager::save_statistics_to_mongodb(mongocxx::database& db,
+void DatabaseManager::write_log_records(CollectionHandles& handles,
+                                        const std::string& device_id,
+                                        const std::string& log_level,
+                                        const std::vector<TelemetryRecord>& records,
+                                        const std::vector<std::string>& severities,
+                                        const std::string& topic,
+                                        const DeviceContext& device,
+                                        mqtt::async_client* mqtt_client,
+                                        std::chrono::system_clock::time_point now) {
+    auto ingestion_time = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+
+    // log_stream 생성
+    std::string log_stream = make_log_stream(device_id, log_level, now);
+
+    // 레코드별 저장 후 처리에 필요한 값
+    struct Saved {
+        std::string structured_id;
+        std::string severity;
+        int64_t timestamp;
+    };
+    std::vector<Saved> saved;
+    std::vector<bsoncxx::document::value> documents;
+    saved.reserve(records.size());
+    documents.reserve(records.size());
+
+    for (size_t i = 0; i < records.size(); ++i) {
+        const TelemetryRecord& record = records[i];
+        const std::string& log_code = record.log_code;
+        const std::string& severity = severities[i];
+
+        // 구조화된 ID 생성
+        std::string structured_id = device.device_code + "-" + log_code + "-" + generate_ulid();
+
+        int64_t timestamp = record.has_timestamp ? record.timestamp : ingestion_time;
+
+        // BSON 문서 빌드
+        documents.push_back(build_log_document(structured_id, device_id, log_level, log_stream, topic,
+                                               device, record, severity, timestamp, ingestion_time));
+        saved.push_back(Saved{structured_id, severity, timestamp});
+    }
+
+    // MongoDB에 데이터 삽입
+    std::cout << "\n=== Saving Log Document ===" << std::endl;
+    if (records.size() == 1) {
+        std::cout << "Structured ID: " << saved[0].structured_id << std::endl;
+        std::cout << "Device: " << device_id << " (" << device.device_code << ")" << std::endl;
+        std::cout << "Log Code: " << records[0].log_code << " | Severity: " << saved[0].severity << std::endl;
+        std::cout << "Message: " << records[0].message << std::endl;
+    } else {
+        std::cout << "Batch: " << records.size() << " logs" << std::endl;
+        std::cout << "Device: " << device_id << " (" << device.device_code << ")" << std::endl;
+    }
+    std::cout << "Log Stream: " << log_stream << std::endl;
+
+    // 저장 후 처리: 캐시 무효화, 메모리 저장소 반영, 실시간 구독자 전달
+    auto deliver = [&]() {
+        std::unordered_set<std::string> invalidated;
+        for (size_t i = 0; i < records.size(); ++i) {
+            const auto& record = records[i];
+            const auto& entry = saved[i];
+
+            // 이 로그와 매칭될 수 있는 캐시 항목 무효화
+            if (invalidated.insert(record.log_code).second) {
+                query_cache.invalidate(device_id, record.log_code);
+            }
+
+            // 최근 구간 메모리 저장소에 추가
+            hot_store.append(entry.structured_id, device_id, device.device_name, device.location,
+                             record.log_code, log_level, entry.severity, record.message, entry.timestamp);
+
+            // 실시간 구독자에게 전달
+            publish_to_subscribers(mqtt_client, documents[i].view(), device_id, log_level,
+                                   record.log_code, entry.severity, entry.timestamp);
+        }
+    };
+
+    // 비동기 기록: 먼저 메모리/구독자에 반영하고 기록 스레드에 넘김
+    // 기록 전에 캐시된 조회 결과가 남지 않도록 기록이 끝나면 한 번 더 무효화
+    if (log_writer.enabled()) {
+        deliver();
+        std::vector<std::string> targets;
+        if (!device.group_collection.empty()) targets.push_back(device.group_collection);
+        targets.push_back(config.all_logs_collection());
+
+        std::unordered_set<std::string> codes;
+        for (const auto& record : records) codes.insert(record.log_code);
+        std::vector<std::string> log_codes(codes.begin(), codes.end());
+        auto on_written = [this, device_id, log_codes = std::move(log_codes)]() {
+            for (const auto& log_code : log_codes) query_cache.invalidate(device_id, log_code);
+        };
+        if (log_writer.enqueue(std::move(targets), std::move(documents), log_level, std::move(on_written))) {
+            std::cout << "✓ Queued for async write (" << records.size() << " logs)" << std::endl;
+            state_persister.mark(device_id);
+            std::cout << "=========================\n" << std::endl;
+            return;
+        }
+        std::cout << "Log writer queue unavailable, writing synchronously" << std::endl;
+    }
+
+    // 배치는 컬렉션별로 한 번에 삽입 (logs_all은 파티션 사용 시 문서 timestamp 기준으로 나눔)
+    auto insert = [&](const std::string& collection_name) {
+        std::map<std::string, std::vector<bsoncxx::document::view>> routed;
+        for (const auto& doc : documents) {
+            routed[partitions.route(collection_name, doc.view())].push_back(doc.view());
+        }
+        for (const auto& [name, views] : routed) {
+            auto& collection = handles.collection(name);
+            if (views.size() == 1) {
+                collection.insert_one(views[0], handles.insert_options(log_level));
+            } else {
+                collection.insert_many(views, handles.insert_options(log_level));
+            }
+            partitions.note(name);
+        }
+    };
+
+    // 그룹별 전용 컬렉션에 삽입
+    if (!device.group_collection.empty()) {
+        Tracer::Span span(Tracer::INSERT_GROUP);
+        insert(device.group_collection);
+        std::cout << "✓ Saved to group collection: " << device.group_collection << std::endl;
+    }
+
+    // logs_all 컬렉션에 삽입
+    {
+        Tracer::Span span(Tracer::INSERT_ALL);
+        insert(config.all_logs_collection());
+    }
+    std::cout << "✓ Saved to " << config.all_logs_collection() << " collection" << std::endl;
+
+    if (!log_writer.enabled()) deliver();
+    state_persister.mark(device_id);
+    std::cout << "=========================\n" << std::endl;
+}
+
+DatabaseManager::FlushResult DatabaseManager::flush_pending(CollectionHandles& handles,
+                                                            mqtt::async_client* mqtt_client) {
+    return write_pending(handles, ingest_policy.flush(), mqtt_client);
+}
+
+DatabaseManager::FlushResult DatabaseManager::write_pending(CollectionHandles& handles,
+                                                            std::vector<IngestPolicy::Pending> pending,
+                                                            mqtt::async_client* mqtt_client) {
+    FlushResult result;
+    if (pending.empty()) return result;
+
+    // 디바이스/레벨별로 모아 한 번에 저장 (이미 집계된 레코드이므로 저장 정책은 다시 적용하지 않음)
+    std::map<std::pair<std::string, std::string>, std::vector<TelemetryRecord>> groups;
+    for (auto& item : pending) {
+        groups[{item.device_id, item.log_level}].push_back(std::move(item.record));
+    }
+
+    auto now = std::chrono::system_clock::now();
+    for (const auto& [key, records] : groups) {
+        const auto& [device_id, log_level] = key;
+        try {
+            auto device = get_device_info(handles, device_id);
+            if (!device) throw std::runtime_error("device not found");
+            std::vector<std::string> severities;
+            severities.reserve(records.size());
+            for (const auto& record : records) {
+                severities.push_back(device->severity_rules.evaluate(record.log_code, record.metadata));
+            }
+            write_log_records(handles, device_id, log_level, records, severities,
+                              "factory/" + device_id + "/log/" + log_level, *device, mqtt_client, now);
+            result.flushed += records.size();
+        } catch (const std::exception& e) {
+            std::cerr << "Error flushing pending logs for " << device_id << ": " << e.what() << std::endl;
+            result.abandoned += records.size();
+        }
+    }
+    return result;
+}
+
+void DatabaseManager::save_statistics_to_mongodb(CollectionHandles& handles,
                                                 const std::string& device_id,
                                                 const json& payload) {
+    save_statistics_batch(handles, device_id, {payload});
+}
+
+void DatabaseManager::save_statistics_batch(CollectionHandles& handles,
+                                            const std::string& device_id,
+                                            const std::vector<json>& payloads) {
+    if (payloads.empty()) return;
+
     try {
         std::cout << "\n=========================" << std::endl;
         std::cout << "Saving statistics data for device: " << device_id << std::endl;
@@ -521,38 +1089,73 @@ void DatabaseManager::save_statistics_to_mongodb(mongocxx::database& db,
         // 현재 시간 생성
         auto now = std::chrono::system_clock::now();
         auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-        
-        // message 객체에서 통계 데이터 추출
-        json message = payload["message"];
-        json time_range = payload["time_range"];
-        
-        // BSON 문서 생성
-        bson_builder doc{};
-        doc << "_id" << generate_ulid()
-            << "device_id" << device_id
-            << "log_code" << payload.value("log_code", "")
-            << "statistics" << bsoncxx::builder::stream::open_document
-                << "total" << message.value("total", "")
-                << "pass" << message.value("pass", "")
-                << "fail" << message.value("fail", "")
-                << "failure" << message.value("failure", "")
-            << bsoncxx::builder::stream::close_document
-            << "time_range" << bsoncxx::builder::stream::open_document
-                << "start" << time_range.value("start", 0)
-                << "end" << time_range.value("end", 0)
-            << bsoncxx::builder::stream::close_document
-            << "created_at" << bsoncxx::types::b_date{std::chrono::milliseconds{timestamp}};
-        
-        auto doc_value = doc << finalize;
+
+        std::vector<bsoncxx::document::value> documents;
+        documents.reserve(payloads.size());
+        std::unordered_set<std::string> log_codes;
+        json latest;
+
+        for (const auto& payload : payloads) {
+            // message 객체에서 통계 데이터 추출
+            json message = payload["message"];
+            json time_range = payload["time_range"];
+            
+            // BSON 문서 생성
+            bson_builder doc{};
+            doc << "_id" << generate_ulid()
+                << "device_id" << device_id
+                << "log_code" << payload.value("log_code", "")
+                << "statistics" << bsoncxx::builder::stream::open_document
+                    << "total" << message.value("total", "")
+                    << "pass" << message.value("pass", "")
+                    << "fail" << message.value("fail", "")
+                    << "failure" << message.value("failure", "")
+                << bsoncxx::builder::stream::close_document
+                << "time_range" << bsoncxx::builder::stream::open_document
+                    << "start" << time_range.value("start", 0)
+                    << "end" << time_range.value("end", 0)
+                << bsoncxx::builder::stream::close_document
+                << "created_at" << bsoncxx::types::b_date{std::chrono::milliseconds{timestamp}};
+            
+            documents.push_back(doc << finalize);
+            log_codes.insert(payload.value("log_code", ""));
+
+            // 최신 통계는 조회 응답 형식 그대로 보관 (배치에서는 마지막 항목)
+            latest = {
+                {"log_code", payload.value("log_code", "")},
+                {"message", {
+                    {"total", message.value("total", "")},
+                    {"pass", message.value("pass", "")},
+                    {"fail", message.value("fail", "")},
+                    {"failure", message.value("failure", "")}
+                }},
+                {"time_range", {
+                    {"start", time_range.value("start", int64_t{0})},
+                    {"end", time_range.value("end", int64_t{0})}
+                }}
+            };
+
+            std::cout << "  - Total: " << message.value("total", "")
+                      << " | Pass: " << message.value("pass", "")
+                      << " | Fail: " << message.value("fail", "")
+                      << " | Failure rate: " << message.value("failure", "") << std::endl;
+        }
         
         // statistics 컬렉션에 저장
-        db[config.statistics_collection()].insert_one(doc_value.view());
+        auto& collection = handles.collection(config.statistics_collection());
+        if (documents.size() == 1) {
+            collection.insert_one(documents[0].view());
+        } else {
+            collection.insert_many(documents);
+        }
+        for (const auto& log_code : log_codes) {
+            query_cache.invalidate(device_id, log_code);
+        }
+
+        device_states.update_statistics(device_id, latest, timestamp);
+        state_persister.mark(device_id);
         
-        std::cout << "✓ Statistics saved to " << config.statistics_collection() << " collection" << std::endl;
-        std::cout << "  - Total: " << message.value("total", "") << std::endl;
-        std::cout << "  - Pass: " << message.value("pass", "") << std::endl;
-        std::cout << "  - Fail: " << message.value("fail", "") << std::endl;
-        std::cout << "  - Failure rate: " << message.value("failure", "") << std::endl;
+        std::cout << "✓ " << documents.size() << " statistics saved to " << config.statistics_collection() << " collection" << std::endl;
         std::cout << "=========================\n" << std::endl;
         
     } catch (const std::exception& e) {
@@ -560,16 +1163,56 @@ void DatabaseManager::save_statistics_to_mongodb(mongocxx::database& db,
     }
 }
 
-void DatabaseManager::process_statistics_data_request(mongocxx::client& mongo_client,
+void DatabaseManager::process_statistics_data_request(CollectionHandles& handles,
                                                      mqtt::async_client* mqtt_client,
                                                      const std::string& device_id,
                                                      const std::string& response_topic) {
     try {
         std::cout << "\n=========================" << std::endl;
         std::cout << "Processing statistics data request for device: " << device_id << std::endl;
+
+        // 최신 상태 테이블에 통계가 있으면 DB 조회 없이 응답
+        json latest_statistics;
+        if (mqtt_client && device_states.latest_statistics(device_id, latest_statistics)) {
+            json response;
+            response["device_id"] = device_id;
+            response["status"] = "success";
+            response["data"] = latest_statistics;
+
+            auto msg = mqtt::make_message(response_topic, response.dump());
+            msg->set_qos(1);
+            mqtt_client->publish(msg);
+            std::cout << "✓ Response served from latest state: " << response_topic << std::endl;
+            return;
+        }
+
+        // 캐시된 최신 통계가 있으면 DB 조회 없이 응답
+        std::string cache_key = "statistics_data|" + device_id;
+        std::string cached;
+        if (mqtt_client && query_cache.get(cache_key, cached)) {
+            auto msg = mqtt::make_message(response_topic, cached);
+            msg->set_qos(1);
+            mqtt_client->publish(msg);
+            std::cout << "✓ Response served from cache: " << response_topic << std::endl;
+            return;
+        }
+
+        // 같은 디바이스 요청이 처리 중이면 그 응답을 함께 전송
+        uint64_t cache_generation = query_cache.generation({device_id, "INF"});
+        auto ticket = request_dedup.join(cache_key);
+        if (!ticket.leader) {
+            std::string shared = ticket.result.get();
+            if (mqtt_client && !shared.empty()) {
+                auto msg = mqtt::make_message(response_topic, shared);
+                msg->set_qos(1);
+                mqtt_client->publish(msg);
+                std::cout << "✓ Response coalesced with in-flight request: " << response_topic << std::endl;
+            }
+            return;
+        }
+        RequestDeduplicator::Completion completion(request_dedup, ticket, cache_key);
         
-        auto db = mongo_client[config.mongo_db_name()];
-        auto collection = db[config.statistics_collection()];
+        auto& collection = handles.collection(config.statistics_collection());
         
         // 해당 디바이스의 가장 최근 통계 데이터 조회
         mongocxx::options::find opts{};
@@ -608,8 +1251,11 @@ void DatabaseManager::process_statistics_data_request(mongocxx::client& mongo_cl
         }
         
         // MQTT로 응답 전송
+        std::string response_str = response.dump();
+        query_cache.put(cache_key, response_str, {device_id, "INF"}, cache_generation);
+        completion.set(response_str);
+
         if (mqtt_client) {
-            std::string response_str = response.dump();
             auto msg = mqtt::make_message(response_topic, response_str);
             msg->set_qos(1);
             mqtt_client->publish(msg);
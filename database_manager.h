@@ -1,26 +1,158 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 #include <optional>
+#include <chrono>
 #include <nlohmann/json.hpp>
 #include <mongocxx/client.hpp>
 #include <mongocxx/database.hpp>
+#include <mongocxx/pipeline.hpp>
 #include <bsoncxx/document/value.hpp>
 #include <bsoncxx/document/view.hpp>
 #include <mqtt/async_client.h>
 #include "config.h"
+#include "log_filter.h"
+#include "subscription_manager.h"
+#include "query_cache.h"
+#include "device_state_table.h"
+#include "log_archive.h"
+#include "hot_store.h"
+#include "sketches.h"
+#include "device_cache.h"
+#include "request_deduplicator.h"
+#include "telemetry_record.h"
+#include "device_context.h"
+#include "ingest_policy.h"
+#include "collection_handles.h"
+#include "snapshot_store.h"
+#include "tracer.h"
+#include "log_writer.h"
+#include "log_partitions.h"
+#include "event_clock.h"
+#include "alarm_engine.h"
+#include "response_encoder.h"
+#include "device_state_persister.h"
 
 using json = nlohmann::json;
 
 class DatabaseManager {
 private:
     const Config& config;
+    SubscriptionManager subscriptions;
+    QueryCache query_cache;
+    DeviceStateTable device_states;
+    LogArchive log_archive;
+    HotStore hot_store;
+    SketchStore sketches;
+    DeviceCache device_cache;
+    RequestDeduplicator request_dedup;
+    IngestPolicy ingest_policy;
+    EventClock event_clock;
+    AlarmEngine alarms;
+    LogPartitions partitions;
+    SnapshotStore snapshots;
+    Tracer tracer;
+    LogWriter log_writer;
+    ResponseEncoder response_encoder;
+    DeviceStatePersister state_persister;   // 최신 상태 MongoDB 저장 (DEVICE_STATE_PERSIST=true 인 경우)
+
+    // "All" 통계 대상 디바이스 (logs_all에 숫자 메시지가 있는 디바이스, DEVICE_CACHE_TTL_SEC마다 다시 조회)
+    std::mutex numeric_devices_mutex;
+    std::set<std::string> numeric_devices;
+    int64_t numeric_devices_loaded_at = 0;
+
+    // 마지막 "All" 통계 요청 처리 결과
+    std::atomic<size_t> last_fanout_devices{0};
+    std::atomic<int64_t> last_fanout_ms{0};
+
+    // 디바이스별 숫자 메시지(속도) 통계
+    struct SpeedStats {
+        double average = 0.0;
+        int current_speed = 0;
+    };
+
+    // 로그 조회 (query_type == "logs" / "subscribe" 공용, 겹치는 파티션만 최신순으로 읽어 병합)
+    json find_logs(CollectionHandles& handles, const LogFilter& filter, int limit);
+
+    // 시간 범위와 겹치는 파티션을 $match 후 $unionWith로 이어 붙인 파이프라인 시작 (집계 대상 컬렉션 반환)
+    mongocxx::collection& match_partitions(CollectionHandles& handles,
+                                           mongocxx::pipeline& pipeline,
+                                           const bsoncxx::document::view& match,
+                                           bool has_range, int64_t start_time, int64_t end_time);
+
+    // 집계 조회 (query_type == "count" / "histogram" / "top_devices")
+    json aggregate_logs(CollectionHandles& handles,
+                        const std::string& query_type,
+                        LogFilter filter,
+                        const json& query);
+
+    // 디바이스별 속도 통계를 $group 한 번으로 계산 (device_id가 비어 있으면 전체)
+    std::unordered_map<std::string, SpeedStats> speed_statistics(CollectionHandles& handles,
+                                                                 const std::string& device_id,
+                                                                 int64_t start_time,
+                                                                 int64_t end_time);
+
+    // 숫자 메시지 로그가 있는 디바이스 목록 (캐시 + 마지막 조회 이후 수집된 디바이스)
+    std::vector<std::string> numeric_device_ids(CollectionHandles& handles);
+
+    // 내부 지표 조회 (query_type == "metrics")
+    void process_metrics_request(mqtt::async_client* mqtt_client, const json& query);
+
+    // 디바이스 최신 상태 조회 (query_type == "device_states")
+    void process_device_states_request(mqtt::async_client* mqtt_client, const json& query);
+
+    // 구독 lease 연장 / 해지 요청 처리
+    void process_subscription_control(mqtt::async_client* mqtt_client, const json& query);
+
+    // 저장 정책을 통과한 레코드를 그룹 컬렉션 / logs_all에 기록하고 캐시, 구독자에 반영 (실패 시 예외)
+    // severities는 records와 같은 순서로 이미 계산된 심각도
+    void write_log_records(CollectionHandles& handles,
+                           const std::string& device_id,
+                           const std::string& log_level,
+                           const std::vector<TelemetryRecord>& records,
+                           const std::vector<std::string>& severities,
+                           const std::string& topic,
+                           const DeviceContext& device,
+                           mqtt::async_client* mqtt_client,
+                           std::chrono::system_clock::time_point now);
+
+    // 신규 로그를 매칭되는 구독 토픽으로 전달
+    void publish_to_subscribers(mqtt::async_client* mqtt_client,
+                                const bsoncxx::document::view& log_doc,
+                                const std::string& device_id,
+                                const std::string& log_level,
+                                const std::string& log_code,
+                                const std::string& severity,
+                                int64_t timestamp);
     
 public:
+    // 종료 시 메모리에 남은 데이터 처리 결과
+    struct FlushResult {
+        size_t flushed = 0;
+        size_t abandoned = 0;
+    };
+
     DatabaseManager(const Config& cfg);
+
+    DeviceStateTable& device_state_table() { return device_states; }
+    LogArchive& archive() { return log_archive; }
+    SnapshotStore& snapshot_store() { return snapshots; }
+    Tracer& tracing() { return tracer; }
+    LogWriter& writer() { return log_writer; }
+    LogPartitions& log_partitions() { return partitions; }
+    QueryCache& cache() { return query_cache; }
+    DeviceStatePersister& state_persistence() { return state_persister; }
+
+    // 저장된 디바이스 최신 상태 로드 (프로그램 시작 시)
+    void load_device_states(mongocxx::client& mongo_client);
     
-    // 디바이스 정보 조회
-    bsoncxx::stdx::optional<bsoncxx::document::value> get_device_info(
-        mongocxx::database& db, const std::string& device_id);
+    // 디바이스 정보 조회 (캐시가 다시 적재되면 이 스레드의 그룹 컬렉션 핸들도 준비)
+    DeviceCache::DevicePtr get_device_info(
+        CollectionHandles& handles, const std::string& device_id);
     
     // Severity 계산
     std::string determine_severity(const std::string& log_code, 
@@ -28,31 +160,62 @@ public:
                                  const bsoncxx::document::view& device_info);
     
     // 쿼리 처리
-    void process_query_request(mongocxx::client& mongo_client, 
+    void process_query_request(CollectionHandles& handles, 
                              mqtt::async_client* mqtt_client, 
                              const json& query);
 
     // 통계 처리
-    void process_statistics_request(mongocxx::client& mongo_client,
+    void process_statistics_request(CollectionHandles& handles,
                                   mqtt::async_client* mqtt_client,
                                   const json& request);
     
     // 로그 저장
-    void save_log_to_mongodb(mongocxx::database& db, 
+    void save_log_to_mongodb(CollectionHandles& handles, 
                            const std::string& device_id,
                            const std::string& log_level,
                            const json& payload,
                            const std::string& topic,
-                           const bsoncxx::document::view& device_info);
+                           const DeviceContext& device,
+                           mqtt::async_client* mqtt_client);
+
+    // 바이너리 페이로드 등 이미 디코딩된 로그 저장
+    void save_log_to_mongodb(CollectionHandles& handles, 
+                           const std::string& device_id,
+                           const std::string& log_level,
+                           const TelemetryRecord& record,
+                           const std::string& topic,
+                           const DeviceContext& device,
+                           mqtt::async_client* mqtt_client);
+    
+    // 같은 디바이스/레벨 로그 여러 건을 컬렉션별 한 번의 삽입으로 저장
+    void save_log_batch(CollectionHandles& handles,
+                        const std::string& device_id,
+                        const std::string& log_level,
+                        const std::vector<TelemetryRecord>& records,
+                        const std::string& topic,
+                        const DeviceContext& device,
+                        mqtt::async_client* mqtt_client);
+    
+    // 저장 정책의 열린 집계 구간을 닫아 저장 (종료 시)
+    FlushResult flush_pending(CollectionHandles& handles, mqtt::async_client* mqtt_client);
     
     // 통계 데이터 저장
-    void save_statistics_to_mongodb(mongocxx::database& db,
+    void save_statistics_to_mongodb(CollectionHandles& handles,
                                    const std::string& device_id,
                                    const json& payload);
+    void save_statistics_batch(CollectionHandles& handles,
+                               const std::string& device_id,
+                               const std::vector<json>& payloads);
     
     // 통계 데이터 조회
-    void process_statistics_data_request(mongocxx::client& mongo_client,
+    void process_statistics_data_request(CollectionHandles& handles,
                                        mqtt::async_client* mqtt_client,
                                        const std::string& device_id,
                                        const std::string& topic);
+
+private:
+    // 저장 정책이 강제로 닫은 집계 레코드를 디바이스/레벨별로 저장
+    FlushResult write_pending(CollectionHandles& handles,
+                              std::vector<IngestPolicy::Pending> pending,
+                              mqtt::async_client* mqtt_client);
 };
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "device_cache.h"
+#include <chrono>
+#include <mutex>
+#include <iostream>
+#include <unordered_set>
+#include <bsoncxx/builder/stream/document.hpp>
+
+namespace {
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+DeviceCache::DeviceCache(const Config& cfg)
+    : config(cfg) {}
+
+void DeviceCache::refresh_if_stale(CollectionHandles& handles) {
+    int64_t now = now_ms();
+    int64_t ttl_ms = config.device_cache_ttl_sec() * 1000;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (loaded_at != 0 && now - loaded_at < ttl_ms) return;
+    }
+
+    // 잠금 밖에서 조회 후 교체
+    std::unordered_map<std::string, DevicePtr> loaded;
+    std::unordered_set<std::string> groups;
+    auto cursor = handles.collection(config.devices_collection()).find({});
+    for (auto&& doc : cursor) {
+        if (!doc["_id"] || doc["_id"].type() != bsoncxx::type::k_string) continue;
+        std::string device_id(doc["_id"].get_string().value);
+        try {
+            auto device = std::make_shared<const DeviceContext>(DeviceContext::from_device(doc));
+            if (!device->group_collection.empty()) groups.insert(device->group_collection);
+            loaded.emplace(std::move(device_id), std::move(device));
+        } catch (const std::exception& e) {
+            std::cerr << "Skipping invalid device '" << device_id << "': " << e.what() << std::endl;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    devices.swap(loaded);
+    group_names.assign(groups.begin(), groups.end());
+    loaded_at = now;
+    ++loaded_generation;
+    std::cout << "Device cache loaded: " << devices.size() << " devices" << std::endl;
+}
+
+DeviceCache::DevicePtr DeviceCache::get(CollectionHandles& handles, const std::string& device_id) {
+    refresh_if_stale(handles);
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = devices.find(device_id);
+        if (it != devices.end()) {
+            ++hits;
+            return it->second;
+        }
+        ++misses;
+    }
+
+    // 마지막 적재 이후 등록된 디바이스
+    bsoncxx::builder::stream::document builder;
+    builder << "_id" << device_id;
+    auto found = handles.collection(config.devices_collection()).find_one(builder.view());
+    if (!found) return nullptr;
+
+    auto device = std::make_shared<const DeviceContext>(DeviceContext::from_device(found->view()));
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    devices[device_id] = device;
+    return device;
+}
+
+std::vector<std::string> DeviceCache::device_ids(CollectionHandles& handles) {
+    refresh_if_stale(handles);
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::string> ids;
+    ids.reserve(devices.size());
+    for (const auto& [device_id, device] : devices) ids.push_back(device_id);
+    return ids;
+}
+
+std::vector<std::string> DeviceCache::group_collections() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return group_names;
+}
+
+json DeviceCache::snapshot() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    json result = json::object();
+    for (const auto& [device_id, device] : devices) {
+        result[device_id] = device->to_json();
+    }
+    return result;
+}
+
+void DeviceCache::restore(const json& snapshot, int64_t age_ms) {
+    std::unordered_map<std::string, DevicePtr> restored;
+    std::unordered_set<std::string> groups;
+    for (const auto& [device_id, value] : snapshot.items()) {
+        auto device = std::make_shared<const DeviceContext>(DeviceContext::from_json(value));
+        if (!device->group_collection.empty()) groups.insert(device->group_collection);
+        restored.emplace(device_id, std::move(device));
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    devices.swap(restored);
+    group_names.assign(groups.begin(), groups.end());
+    // 스냅샷 시점에 적재한 것으로 보고 남은 TTL 동안만 사용
+    loaded_at = now_ms() - age_ms;
+    ++loaded_generation;
+}
+
+json DeviceCache::stats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    json result;
+    result["devices"] = devices.size();
+    result["group_collections"] = group_names.size();
+    result["generation"] = loaded_generation.load();
+    result["hits"] = hits.load();
+    result["misses"] = misses.load();
+    return result;
+}
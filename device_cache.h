@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <mongocxx/client.hpp>
+#include <nlohmann/json.hpp>
+#include "config.h"
+#include "device_context.h"
+#include "collection_handles.h"
+
+using json = nlohmann::json;
+
+// devices 컬렉션 메모리 캐시
+// 주기적으로 전체를 다시 읽고, 그 사이 새로 등록된 디바이스는 개별 조회로 보충한다.
+// 적재 시 디바이스 문서를 DeviceContext(그룹 컬렉션 이름, 심각도 규칙 포함)로 바꿔 보관한다.
+class DeviceCache {
+public:
+    using DevicePtr = std::shared_ptr<const DeviceContext>;
+
+private:
+    const Config& config;
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, DevicePtr> devices;
+    std::vector<std::string> group_names;   // 적재된 디바이스의 그룹 컬렉션 이름 (중복 제거)
+    int64_t loaded_at = 0;
+    std::atomic<uint64_t> loaded_generation{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+
+    // TTL이 지났으면 전체 목록 재적재
+    void refresh_if_stale(CollectionHandles& handles);
+
+public:
+    DeviceCache(const Config& cfg);
+
+    DevicePtr get(CollectionHandles& handles, const std::string& device_id);
+    std::vector<std::string> device_ids(CollectionHandles& handles);
+
+    // 전체 재적재 횟수 (스레드별 컬렉션 핸들 준비 여부 판단용)
+    uint64_t generation() const { return loaded_generation.load(); }
+    std::vector<std::string> group_collections() const;
+
+    // 스냅샷 저장/복원 (age_ms: 스냅샷 이후 지난 시간, TTL 만료 시각 계산용)
+    json snapshot() const;
+    void restore(const json& snapshot, int64_t age_ms);
+
+    json stats() const;
+};
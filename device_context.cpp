@@ -0,0 +1,109 @@
+#include "device_context.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+std::string string_field(const bsoncxx::document::view& doc, const char* key, const char* fallback) {
+    return doc[key] ? std::string(doc[key].get_string().value) : fallback;
+}
+}
+
+SeverityRules SeverityRules::from_device(const bsoncxx::document::view& device_info) {
+    SeverityRules rules;
+    if (!device_info["thresholds"]) return rules;
+    rules.has_thresholds = true;
+
+    try {
+        auto thresholds = device_info["thresholds"].get_document().view();
+        if (!thresholds["temperature"]) return rules;
+        rules.has_temperature = true;
+
+        rules.temperature_critical = thresholds["temperature"]["critical"].get_double();
+        rules.temperature_high = thresholds["temperature"]["high"].get_double();
+        rules.temperature_medium = thresholds["temperature"]["medium"].get_double();
+        rules.temperature_valid = true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading severity thresholds: " << e.what() << std::endl;
+    }
+    return rules;
+}
+
+std::string SeverityRules::evaluate(const std::string& log_code, const json& metadata) const {
+    if (!has_thresholds) return "UNKNOWN";
+
+    if (log_code == "TMP" && has_temperature && metadata.is_object() && metadata.contains("temperature")) {
+        if (!temperature_valid || !metadata["temperature"].is_number()) return "MEDIUM";
+        double temp = metadata["temperature"];
+        if (temp >= temperature_critical) return "CRITICAL";
+        if (temp >= temperature_high) return "HIGH";
+        if (temp >= temperature_medium) return "MEDIUM";
+        return "LOW";
+    }
+    // 다른 log_code (COL, SPD 등)에 대한 규칙을 여기에 추가
+
+    return "MEDIUM"; // 기본값
+}
+
+DeviceContext DeviceContext::from_device(const bsoncxx::document::view& device_info) {
+    DeviceContext context;
+    context.device_code = string_field(device_info, "device_code", "NA");
+    context.device_name = string_field(device_info, "device_name", "N/A");
+    context.device_type = string_field(device_info, "device_type", "N/A");
+    context.location = string_field(device_info, "location", "N/A");
+    context.log_group = string_field(device_info, "log_group", "unknown_group");
+
+    // 그룹별 전용 컬렉션 이름 (logs_{log_group}, '/' '-' -> '_')
+    if (device_info["log_group"]) {
+        std::string group_str = context.log_group;
+        std::replace(group_str.begin(), group_str.end(), '/', '_');
+        std::replace(group_str.begin(), group_str.end(), '-', '_');
+        if (!group_str.empty() && group_str.front() == '_') {
+            group_str.erase(0, 1);
+        }
+        context.group_collection = "logs_" + group_str;
+    }
+
+    context.severity_rules = SeverityRules::from_device(device_info);
+    return context;
+}
+
+json SeverityRules::to_json() const {
+    return json{{"has_thresholds", has_thresholds},
+                {"has_temperature", has_temperature},
+                {"temperature_valid", temperature_valid},
+                {"temperature", {temperature_medium, temperature_high, temperature_critical}}};
+}
+
+SeverityRules SeverityRules::from_json(const json& value) {
+    SeverityRules rules;
+    rules.has_thresholds = value.at("has_thresholds").get<bool>();
+    rules.has_temperature = value.at("has_temperature").get<bool>();
+    rules.temperature_valid = value.at("temperature_valid").get<bool>();
+    const auto& temperature = value.at("temperature");
+    rules.temperature_medium = temperature.at(0).get<double>();
+    rules.temperature_high = temperature.at(1).get<double>();
+    rules.temperature_critical = temperature.at(2).get<double>();
+    return rules;
+}
+
+json DeviceContext::to_json() const {
+    return json{{"device_code", device_code},
+                {"device_name", device_name},
+                {"device_type", device_type},
+                {"location", location},
+                {"log_group", log_group},
+                {"group_collection", group_collection},
+                {"severity_rules", severity_rules.to_json()}};
+}
+
+DeviceContext DeviceContext::from_json(const json& value) {
+    DeviceContext context;
+    context.device_code = value.at("device_code").get<std::string>();
+    context.device_name = value.at("device_name").get<std::string>();
+    context.device_type = value.at("device_type").get<std::string>();
+    context.location = value.at("location").get<std::string>();
+    context.log_group = value.at("log_group").get<std::string>();
+    context.group_collection = value.at("group_collection").get<std::string>();
+    context.severity_rules = SeverityRules::from_json(value.at("severity_rules"));
+    return context;
+}
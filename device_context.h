@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <bsoncxx/document/view.hpp>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// 디바이스 thresholds 기반 심각도 규칙 (디바이스 문서에서 한 번만 읽어 재사용)
+struct SeverityRules {
+    bool has_thresholds = false;
+    bool has_temperature = false;
+    bool temperature_valid = false;   // thresholds.temperature 값이 모두 double인지
+    double temperature_medium = 0.0;
+    double temperature_high = 0.0;
+    double temperature_critical = 0.0;
+
+    static SeverityRules from_device(const bsoncxx::document::view& device_info);
+    std::string evaluate(const std::string& log_code, const json& metadata) const;
+
+    // 스냅샷 저장/복원
+    json to_json() const;
+    static SeverityRules from_json(const json& value);
+};
+
+// 로그 문서에 반복해서 들어가는 디바이스 필드
+// 배치 저장 시 레코드마다 디바이스 문서를 다시 읽지 않도록 미리 계산해 둔다.
+struct DeviceContext {
+    std::string device_code;
+    std::string device_name;
+    std::string device_type;
+    std::string location;
+    std::string log_group;
+    std::string group_collection;   // log_group이 없으면 빈 문자열
+    SeverityRules severity_rules;
+
+    static DeviceContext from_device(const bsoncxx::document::view& device_info);
+
+    // 스냅샷 저장/복원
+    json to_json() const;
+    static DeviceContext from_json(const json& value);
+};
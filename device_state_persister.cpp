@@ -0,0 +1,117 @@
+#include "device_state_persister.h"
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <bsoncxx/builder/stream/document.hpp>
+#include <bsoncxx/json.hpp>
+#include <mongocxx/client.hpp>
+#include <mongocxx/uri.hpp>
+#include <mongocxx/bulk_write.hpp>
+#include <mongocxx/model/replace_one.hpp>
+#include <mongocxx/options/bulk_write.hpp>
+
+using bson_builder = bsoncxx::builder::stream::document;
+using bsoncxx::builder::stream::finalize;
+
+DeviceStatePersister::DeviceStatePersister(const Config& cfg, DeviceStateTable& states)
+    : config(cfg), device_states(states) {}
+
+DeviceStatePersister::~DeviceStatePersister() {
+    stop();
+}
+
+void DeviceStatePersister::start() {
+    if (!enabled()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running) return;
+        running = true;
+    }
+    worker = std::thread(&DeviceStatePersister::run, this);
+    std::cout << "Device state persistence enabled: " << config.device_state_collection()
+              << " (flush " << config.device_state_flush_ms() << " ms)" << std::endl;
+}
+
+void DeviceStatePersister::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void DeviceStatePersister::mark(const std::string& device_id) {
+    if (!enabled()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    dirty.insert(device_id);
+}
+
+void DeviceStatePersister::run() {
+    // mongocxx::client는 스레드 간 공유 불가 → 전용 연결 사용
+    mongocxx::client client{mongocxx::uri{config.mongo_uri()}};
+    CollectionHandles handles(client, config);
+
+    bool stopping = false;
+    while (!stopping) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, std::chrono::milliseconds(config.device_state_flush_ms()), [this] { return !running; });
+            stopping = !running;
+        }
+        // 종료 시에도 마지막으로 한 번 저장
+        flush(handles);
+    }
+}
+
+void DeviceStatePersister::flush(CollectionHandles& handles) {
+    std::unordered_set<std::string> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (dirty.empty()) return;
+        pending.swap(dirty);
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::string> device_ids;
+    try {
+        mongocxx::options::bulk_write opts{};
+        opts.ordered(false);
+        auto bulk = handles.collection(config.device_state_collection()).create_bulk_write(opts);
+        for (const auto& device_id : pending) {
+            json state;
+            if (!device_states.device_json(device_id, state)) continue;
+            mongocxx::model::replace_one upsert{bson_builder{} << "_id" << device_id << finalize,
+                                                bsoncxx::from_json(state.dump())};
+            upsert.upsert(true);
+            bulk.append(upsert);
+            device_ids.push_back(device_id);
+        }
+        if (!device_ids.empty()) bulk.execute();
+    } catch (const std::exception& e) {
+        std::cerr << "Error persisting " << pending.size() << " device states: " << e.what() << std::endl;
+        std::lock_guard<std::mutex> lock(mutex);
+        failed += pending.size();
+        dirty.insert(pending.begin(), pending.end());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++flushes;
+    written += device_ids.size();
+    last_latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+}
+
+json DeviceStatePersister::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    json result;
+    result["enabled"] = enabled();
+    result["pending"] = dirty.size();
+    result["flushes"] = flushes;
+    result["written"] = written;
+    result["failed"] = failed;
+    result["last_latency_ms"] = last_latency_ms;
+    return result;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <mutex>
+#include <cstdint>
+#include <condition_variable>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
+#include "config.h"
+#include "device_state_table.h"
+#include "collection_handles.h"
+
+using json = nlohmann::json;
+
+// 디바이스 최신 상태의 MongoDB 저장 (DEVICE_STATE_PERSIST=true)
+// 수신 경로에서는 변경된 디바이스만 표시하고, 전용 스레드가 DEVICE_STATE_FLUSH_MS마다 모아 한 번의 bulk upsert로 저장한다.
+class DeviceStatePersister {
+private:
+    const Config& config;
+    DeviceStateTable& device_states;
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_set<std::string> dirty;
+    bool running = false;
+
+    // 통계 (mutex 보호)
+    uint64_t flushes = 0;
+    uint64_t written = 0;
+    uint64_t failed = 0;
+    int64_t last_latency_ms = 0;
+
+    void run();
+
+    // 표시된 디바이스 상태 저장 (실패한 디바이스는 다음 주기에 다시 시도)
+    void flush(CollectionHandles& handles);
+
+public:
+    DeviceStatePersister(const Config& cfg, DeviceStateTable& states);
+    ~DeviceStatePersister();
+
+    bool enabled() const { return config.device_state_persist(); }
+
+    void start();
+
+    // 남은 상태를 저장한 뒤 종료
+    void stop();
+
+    // 상태가 바뀐 디바이스 표시
+    void mark(const std::string& device_id);
+
+    json stats() const;
+};
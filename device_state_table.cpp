@@ -0,0 +1,154 @@
+#include "device_state_table.h"
+#include <algorithm>
+#include "string_util.h"
+
+void DeviceStateTable::update_log(const std::string& device_id,
+                                  const std::string& log_code,
+                                  const std::string& log_level,
+                                  const std::string& severity,
+                                  const std::string& message,
+                                  int64_t timestamp,
+                                  int64_t ingestion_time) {
+    LatestValue value{message, log_level, severity, timestamp};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& state = states[device_id];
+    state.last_seen = std::max(state.last_seen, ingestion_time);
+
+    // 최신 값은 수신 순서가 아니라 이벤트 시각 기준 (재연결 후 재전송된 과거 로그로 덮어쓰지 않음)
+    if (string_util::is_numeric(message) && (!state.has_numeric || timestamp >= state.last_numeric.timestamp)) {
+        state.last_numeric = value;
+        state.has_numeric = true;
+    }
+    auto it = state.latest.find(log_code);
+    if (it == state.latest.end()) {
+        state.latest.emplace(log_code, std::move(value));
+    } else if (timestamp >= it->second.timestamp) {
+        it->second = std::move(value);
+    }
+}
+
+void DeviceStateTable::update_statistics(const std::string& device_id, const json& statistics, int64_t ingestion_time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& state = states[device_id];
+    state.last_seen = std::max(state.last_seen, ingestion_time);
+    state.statistics = statistics;
+}
+
+void DeviceStateTable::set_shutdown(const std::string& device_id, bool shutdown) {
+    std::lock_guard<std::mutex> lock(mutex);
+    states[device_id].shutdown = shutdown;
+}
+
+bool DeviceStateTable::latest_numeric(const std::string& device_id, LatestValue& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = states.find(device_id);
+    if (it == states.end() || !it->second.has_numeric) return false;
+    out = it->second.last_numeric;
+    return true;
+}
+
+bool DeviceStateTable::latest_statistics(const std::string& device_id, json& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = states.find(device_id);
+    if (it == states.end() || it->second.statistics.is_null()) return false;
+    out = it->second.statistics;
+    return true;
+}
+
+std::vector<std::string> DeviceStateTable::numeric_device_ids() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> ids;
+    for (const auto& [device_id, state] : states) {
+        if (state.has_numeric) ids.push_back(device_id);
+    }
+    return ids;
+}
+
+json DeviceStateTable::to_json(const std::string& device_id, const DeviceState& state) {
+    json result;
+    result["device_id"] = device_id;
+    result["last_seen"] = state.last_seen;
+    result["shutdown"] = state.shutdown;
+
+    json latest = json::object();
+    for (const auto& [log_code, value] : state.latest) {
+        latest[log_code] = {
+            {"message", value.message},
+            {"log_level", value.log_level},
+            {"severity", value.severity},
+            {"timestamp", value.timestamp}
+        };
+    }
+    result["latest"] = latest;
+
+    if (state.has_numeric) {
+        result["current_value"] = {
+            {"message", state.last_numeric.message},
+            {"timestamp", state.last_numeric.timestamp}
+        };
+    }
+    if (!state.statistics.is_null()) {
+        result["statistics"] = state.statistics;
+    }
+    return result;
+}
+
+bool DeviceStateTable::device_json(const std::string& device_id, json& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = states.find(device_id);
+    if (it == states.end()) return false;
+    out = to_json(it->first, it->second);
+    return true;
+}
+
+json DeviceStateTable::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    json devices = json::array();
+    for (const auto& [device_id, state] : states) {
+        devices.push_back(to_json(device_id, state));
+    }
+    return devices;
+}
+
+void DeviceStateTable::restore(const json& state_json) {
+    std::string device_id = state_json.value("device_id", "");
+    if (device_id.empty()) return;
+
+    DeviceState state;
+    state.last_seen = state_json.value("last_seen", int64_t{0});
+
+    if (state_json.contains("latest") && state_json["latest"].is_object()) {
+        for (const auto& [log_code, value] : state_json["latest"].items()) {
+            state.latest[log_code] = LatestValue{
+                value.value("message", ""),
+                value.value("log_level", ""),
+                value.value("severity", ""),
+                value.value("timestamp", int64_t{0})
+            };
+        }
+    }
+    if (state_json.contains("current_value") && state_json["current_value"].is_object()) {
+        const auto& value = state_json["current_value"];
+        state.last_numeric.message = value.value("message", "");
+        state.last_numeric.timestamp = value.value("timestamp", int64_t{0});
+        state.has_numeric = true;
+    }
+    if (state_json.contains("statistics")) {
+        state.statistics = state_json["statistics"];
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& existing = states[device_id];
+    // 이미 수집된 최신 상태가 있으면 덮어쓰지 않음 (shutdown 플래그는 device_states.txt 기준 유지)
+    if (existing.last_seen < state.last_seen) {
+        bool shutdown = existing.shutdown;
+        existing = std::move(state);
+        existing.shutdown = shutdown;
+    }
+}
+
+size_t DeviceStateTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return states.size();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// 디바이스별 최신 상태 테이블 (수집 시 갱신, 조회는 O(1))
+// 로그 코드별 최신 값 / 현재 숫자 값은 이벤트 시각(timestamp)이 가장 큰 로그 기준
+class DeviceStateTable {
+public:
+    struct LatestValue {
+        std::string message;
+        std::string log_level;
+        std::string severity;
+        int64_t timestamp = 0;
+    };
+
+    struct DeviceState {
+        std::unordered_map<std::string, LatestValue> latest;  // log_code -> 이벤트 시각이 가장 늦은 로그
+        LatestValue last_numeric;                              // 이벤트 시각이 가장 늦은 숫자 메시지 (속도 등)
+        bool has_numeric = false;
+        json statistics;                                       // 최신 INF 통계 (log_code, message, time_range)
+        int64_t last_seen = 0;                                 // 마지막 수신 시각 (ingestion_time)
+        bool shutdown = false;
+    };
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, DeviceState> states;
+
+    static json to_json(const std::string& device_id, const DeviceState& state);
+
+public:
+    // 일반 로그 수신
+    void update_log(const std::string& device_id,
+                    const std::string& log_code,
+                    const std::string& log_level,
+                    const std::string& severity,
+                    const std::string& message,
+                    int64_t timestamp,
+                    int64_t ingestion_time);
+
+    // INF 통계 수신 (응답 형식 그대로 보관)
+    void update_statistics(const std::string& device_id, const json& statistics, int64_t ingestion_time);
+
+    void set_shutdown(const std::string& device_id, bool shutdown);
+
+    bool latest_numeric(const std::string& device_id, LatestValue& out) const;
+    bool latest_statistics(const std::string& device_id, json& out) const;
+
+    // 숫자 메시지를 받은 적이 있는 디바이스
+    std::vector<std::string> numeric_device_ids() const;
+
+    // 단일 디바이스 / 전체 디바이스 상태 (JSON)
+    bool device_json(const std::string& device_id, json& out) const;
+    json snapshot() const;
+
+    // 저장된 상태 복원 (device_json 형식)
+    void restore(const json& state);
+
+    size_t size() const;
+};
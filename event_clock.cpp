@@ -0,0 +1,76 @@
+#include "event_clock.h"
+#include <algorithm>
+
+namespace {
+constexpr int64_t SKEW_PERIOD_MS = 5 * 60 * 1000;   // 최소 지연 구간 (직전 구간과 함께 최근 5~10분)
+constexpr double DELAY_EWMA_ALPHA = 0.1;
+}
+
+EventClock::EventClock(const Config& cfg) : config(cfg) {}
+
+EventClock::Arrival EventClock::observe(const std::string& device_id, int64_t event_time, int64_t ingestion_time) {
+    int64_t lateness = config.allowed_lateness_ms();
+    int64_t delay = ingestion_time - event_time;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& clock = devices[device_id];
+
+    if (ingestion_time - clock.period_start >= SKEW_PERIOD_MS) {
+        clock.previous_min_delay_ms = clock.min_delay_ms;
+        clock.min_delay_ms = INT64_MAX;
+        clock.period_start = ingestion_time;
+    }
+    clock.min_delay_ms = std::min(clock.min_delay_ms, delay);
+    clock.last_delay_ms = delay;
+    clock.avg_delay_ms = clock.received == 0 ? delay : clock.avg_delay_ms + DELAY_EWMA_ALPHA * (delay - clock.avg_delay_ms);
+    ++clock.received;
+
+    Arrival arrival = Arrival::IN_ORDER;
+    if (clock.max_event_time != INT64_MIN && event_time < clock.max_event_time) {
+        ++clock.out_of_order;
+        arrival = Arrival::LATE;
+        if (event_time < clock.max_event_time - lateness) {
+            ++clock.too_late;
+            arrival = Arrival::TOO_LATE;
+        }
+    }
+    clock.max_event_time = std::max(clock.max_event_time, event_time);
+    return arrival;
+}
+
+int64_t EventClock::watermark(const std::string& device_id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = devices.find(device_id);
+    if (it == devices.end() || it->second.max_event_time == INT64_MIN) return INT64_MIN;
+    return it->second.max_event_time - config.allowed_lateness_ms();
+}
+
+json EventClock::stats() const {
+    int64_t lateness = config.allowed_lateness_ms();
+    json result;
+    result["allowed_lateness_ms"] = lateness;
+
+    uint64_t out_of_order = 0;
+    uint64_t too_late = 0;
+    json per_device = json::object();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [device_id, clock] : devices) {
+        int64_t min_delay = std::min(clock.min_delay_ms, clock.previous_min_delay_ms);
+        per_device[device_id] = {
+            {"clock_skew_ms", min_delay == INT64_MAX ? 0 : min_delay},   // 양수: 디바이스 시계가 느림, 음수: 빠름
+            {"last_delay_ms", clock.last_delay_ms},
+            {"avg_delay_ms", clock.avg_delay_ms},
+            {"max_event_time", clock.max_event_time},
+            {"watermark", clock.max_event_time - lateness},
+            {"received", clock.received},
+            {"out_of_order", clock.out_of_order},
+            {"too_late", clock.too_late}
+        };
+        out_of_order += clock.out_of_order;
+        too_late += clock.too_late;
+    }
+    result["out_of_order"] = out_of_order;
+    result["too_late"] = too_late;
+    result["devices"] = std::move(per_device);
+    return result;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "config.h"
+
+using json = nlohmann::json;
+
+// 디바이스별 이벤트 시각 워터마크 / 시계 오차 추적
+// 워터마크 = 지금까지 본 최대 이벤트 시각 - ALLOWED_LATENESS_MS.
+// 최대 이벤트 시각보다 이른 로그는 순서가 바뀐 로그(재연결 후 재전송 등), 워터마크보다 이른 로그는 허용 지연을 넘긴 로그다.
+// 시계 오차는 수신 시각 - 이벤트 시각의 최근 최소값으로 추정한다 (가장 빨리 도착한 로그는 전송 지연이 거의 없음).
+class EventClock {
+public:
+    enum class Arrival { IN_ORDER, LATE, TOO_LATE };
+
+private:
+    struct DeviceClock {
+        int64_t max_event_time = INT64_MIN;
+        int64_t last_delay_ms = 0;
+        double avg_delay_ms = 0.0;
+        int64_t min_delay_ms = INT64_MAX;           // 현재 구간 최소 지연
+        int64_t previous_min_delay_ms = INT64_MAX;  // 이전 구간 최소 지연
+        int64_t period_start = 0;
+        uint64_t received = 0;
+        uint64_t out_of_order = 0;
+        uint64_t too_late = 0;
+    };
+
+    const Config& config;
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, DeviceClock> devices;
+
+public:
+    EventClock(const Config& cfg);
+
+    int64_t allowed_lateness_ms() const { return config.allowed_lateness_ms(); }
+
+    // 이벤트 시각 / 수신 시각 반영 후 도착 구분 (반영 전 최대 이벤트 시각 기준)
+    Arrival observe(const std::string& device_id, int64_t event_time, int64_t ingestion_time);
+
+    // 디바이스 워터마크 (수신 이력이 없으면 INT64_MIN)
+    int64_t watermark(const std::string& device_id) const;
+
+    json stats() const;
+};
@@ -0,0 +1,252 @@
+#include "hot_store.h"
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+#include "string_util.h"
+
+namespace {
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const char* SEVERITY_NAMES[] = {"LOW", "MEDIUM", "HIGH", "CRITICAL", "UNKNOWN"};
+constexpr uint8_t SEVERITY_UNKNOWN = 4;
+}
+
+uint32_t StringDictionary::intern(const std::string& value) {
+    auto it = ids.find(value);
+    if (it != ids.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(values.size());
+    values.push_back(value);
+    ids.emplace(value, id);
+    return id;
+}
+
+uint32_t StringDictionary::find(const std::string& value) const {
+    auto it = ids.find(value);
+    return it != ids.end() ? it->second : NOT_FOUND;
+}
+
+HotStore::HotStore(const Config& cfg)
+    : window_ms(cfg.hot_store_hours() * 60 * 60 * 1000),
+      partition_ms(std::max<int64_t>(cfg.hot_store_partition_ms(), 1000)),
+      coverage_start(now_ms()) {}
+
+uint8_t HotStore::encode_severity(const std::string& severity) {
+    for (uint8_t i = 0; i < SEVERITY_UNKNOWN; ++i) {
+        if (severity == SEVERITY_NAMES[i]) return i;
+    }
+    return SEVERITY_UNKNOWN;
+}
+
+const char* HotStore::decode_severity(uint8_t code) {
+    return SEVERITY_NAMES[std::min(code, SEVERITY_UNKNOWN)];
+}
+
+bool HotStore::covers(int64_t start_time) const {
+    if (!enabled()) return false;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return start_time >= coverage_start;
+}
+
+void HotStore::evict_locked(int64_t now) {
+    int64_t cutoff = now - window_ms;
+    while (!partitions.empty() && partitions.begin()->first + partition_ms <= cutoff) {
+        coverage_start = std::max(coverage_start, partitions.begin()->first + partition_ms);
+        partitions.erase(partitions.begin());
+    }
+    coverage_start = std::max(coverage_start, cutoff - cutoff % partition_ms);
+}
+
+void HotStore::append(const std::string& id,
+                      const std::string& device_id,
+                      const std::string& device_name,
+                      const std::string& location,
+                      const std::string& log_code,
+                      const std::string& log_level,
+                      const std::string& severity,
+                      const std::string& message,
+                      int64_t timestamp) {
+    if (!enabled()) return;
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    evict_locked(now_ms());
+
+    // 보유 구간보다 오래된 로그는 MongoDB에서만 조회
+    if (timestamp < coverage_start) {
+        ++dropped;
+        return;
+    }
+
+    Partition& part = partitions[timestamp - timestamp % partition_ms];
+    uint32_t device = part.devices.intern(device_id);
+    if (device >= part.device_meta.size()) part.device_meta.resize(device + 1);
+    part.device_meta[device] = DeviceMeta{device_name, location};
+
+    part.timestamp.push_back(timestamp);
+    part.device.push_back(device);
+    part.log_code.push_back(part.log_codes.intern(log_code));
+    part.log_level.push_back(part.log_levels.intern(log_level));
+    part.severity.push_back(encode_severity(severity));
+    part.message.push_back(part.messages.intern(message));
+    part.id.push_back(id);
+}
+
+void HotStore::record_sample(const std::string& device_id, const std::string& message, int64_t timestamp) {
+    if (!enabled()) return;
+
+    double value = 0.0;
+    if (!string_util::parse_numeric(message, value)) return;
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    evict_locked(now_ms());
+    if (timestamp < coverage_start) return;
+
+    Partition& part = partitions[timestamp - timestamp % partition_ms];
+    part.sample_timestamp.push_back(timestamp);
+    part.sample_device.push_back(part.devices.intern(device_id));
+    part.sample_value.push_back(value);
+}
+
+bool HotStore::select_rows(const Partition& part, const LogFilter& filter, uint8_t severity,
+                           std::vector<uint32_t>& selection) const {
+    selection.clear();
+    uint32_t device = filter.device_id.empty() ? 0 : part.devices.find(filter.device_id);
+    uint32_t log_code = filter.log_code.empty() ? 0 : part.log_codes.find(filter.log_code);
+    uint32_t log_level = filter.log_level.empty() ? 0 : part.log_levels.find(filter.log_level);
+    if (device == StringDictionary::NOT_FOUND || log_code == StringDictionary::NOT_FOUND ||
+        log_level == StringDictionary::NOT_FOUND) {
+        return false;
+    }
+
+    const uint32_t n = static_cast<uint32_t>(part.size());
+    const int64_t lo = filter.has_time_range ? filter.start_time : INT64_MIN;
+    const int64_t hi = filter.has_time_range ? filter.end_time : INT64_MAX;
+    const int64_t* ts = part.timestamp.data();
+
+    selection.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (ts[i] >= lo && ts[i] <= hi) selection.push_back(i);
+    }
+
+    // 조건이 있는 컬럼만 순서대로 선택 벡터를 좁힘
+    auto refine = [&selection](const auto& column, auto wanted) {
+        size_t out = 0;
+        for (uint32_t row : selection) {
+            if (column[row] == wanted) selection[out++] = row;
+        }
+        selection.resize(out);
+    };
+    if (!filter.device_id.empty()) refine(part.device, device);
+    if (!filter.log_code.empty()) refine(part.log_code, log_code);
+    if (!filter.log_level.empty()) refine(part.log_level, log_level);
+    if (!filter.severity.empty()) refine(part.severity, severity);
+    return true;
+}
+
+json HotStore::row_to_json(const Partition& part, size_t row) const {
+    const DeviceMeta& meta = part.device_meta[part.device[row]];
+    json log_item;
+    log_item["_id"] = part.id[row];
+    log_item["device_id"] = part.devices.at(part.device[row]);
+    log_item["device_name"] = meta.device_name;
+    log_item["log_level"] = part.log_levels.at(part.log_level[row]);
+    log_item["log_code"] = part.log_codes.at(part.log_code[row]);
+    log_item["severity"] = decode_severity(part.severity[row]);
+    log_item["message"] = part.messages.at(part.message[row]);
+    log_item["location"] = meta.location;
+    log_item["timestamp"] = part.timestamp[row];
+    return log_item;
+}
+
+json HotStore::find(const LogFilter& filter, int limit, bool& complete) const {
+    json data_array = json::array();
+    complete = false;
+    if (!enabled() || limit <= 0) return data_array;
+
+    uint8_t severity = filter.severity.empty() ? 0 : encode_severity(filter.severity);
+    // LOW/MEDIUM/HIGH/CRITICAL/UNKNOWN 외의 심각도 조건은 MongoDB에서도 결과 없음 (UNKNOWN 행과 섞지 않음)
+    if (!filter.severity.empty() && filter.severity != decode_severity(severity)) {
+        complete = true;
+        return data_array;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    bool range_covered = filter.has_time_range && filter.start_time >= coverage_start;
+
+    struct Candidate {
+        int64_t timestamp;
+        const Partition* part;
+        uint32_t row;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<uint32_t> selection;
+
+    // 최신 구간부터 스캔, limit개를 채우면 더 오래된 구간은 결과에 포함될 수 없음
+    for (auto it = partitions.rbegin(); it != partitions.rend(); ++it) {
+        if (candidates.size() >= static_cast<size_t>(limit)) break;
+        if (filter.has_time_range) {
+            if (it->first > filter.end_time) continue;
+            if (it->first + partition_ms <= filter.start_time) break;
+        }
+        if (!select_rows(it->second, filter, severity, selection)) continue;
+        for (uint32_t row : selection) {
+            candidates.push_back({it->second.timestamp[row], &it->second, row});
+        }
+    }
+
+    size_t count = std::min(candidates.size(), static_cast<size_t>(limit));
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const Candidate& a, const Candidate& b) { return a.timestamp > b.timestamp; });
+    for (size_t i = 0; i < count; ++i) {
+        data_array.push_back(row_to_json(*candidates[i].part, candidates[i].row));
+    }
+
+    // 시간 범위가 보유 구간 안이거나, 범위 없이 limit개를 모두 채운 경우 MongoDB 결과와 동일
+    complete = range_covered || (!filter.has_time_range && count == static_cast<size_t>(limit));
+    return data_array;
+}
+
+HotStore::NumericStats HotStore::numeric_stats(const std::string& device_id,
+                                               int64_t start_time, int64_t end_time) const {
+    NumericStats stats;
+    if (!enabled()) return stats;
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (const auto& [part_start, part] : partitions) {
+        if (part_start > end_time || part_start + partition_ms <= start_time) continue;
+        uint32_t device = part.devices.find(device_id);
+        if (device == StringDictionary::NOT_FOUND) continue;
+        stats.merge(stats_kernels::aggregate_range(part.sample_timestamp.data(), part.sample_device.data(),
+                                                   part.sample_value.data(), part.sample_timestamp.size(),
+                                                   device, start_time, end_time));
+    }
+    return stats;
+}
+
+json HotStore::stats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    size_t rows = 0;
+    size_t samples = 0;
+    size_t messages = 0;
+    std::unordered_set<std::string> devices;
+    for (const auto& [part_start, part] : partitions) {
+        rows += part.size();
+        samples += part.sample_timestamp.size();
+        messages += part.messages.size();
+        for (size_t i = 0; i < part.devices.size(); ++i) devices.insert(part.devices.at(static_cast<uint32_t>(i)));
+    }
+
+    json result;
+    result["enabled"] = enabled();
+    result["partitions"] = partitions.size();
+    result["rows"] = rows;
+    result["samples"] = samples;
+    result["coverage_start"] = coverage_start;
+    result["devices"] = devices.size();
+    result["messages"] = messages;  // 구간별 메시지 사전 항목 합계
+    result["dropped"] = dropped;
+    return result;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "config.h"
+#include "log_filter.h"
+#include "stats_kernels.h"
+
+using json = nlohmann::json;
+
+// 문자열 사전 인코딩 (문자열 <-> 정수 ID)
+class StringDictionary {
+private:
+    std::vector<std::string> values;
+    std::unordered_map<std::string, uint32_t> ids;
+
+public:
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+    uint32_t intern(const std::string& value);
+    uint32_t find(const std::string& value) const;
+    const std::string& at(uint32_t id) const { return values[id]; }
+    size_t size() const { return values.size(); }
+};
+
+// 최근 N시간 로그의 메모리 컬럼 저장소
+// 시간 구간(partition) 단위로 나누고, 각 구간은 컬럼별 배열(struct-of-arrays)로 저장한다.
+// 조회/통계 요청의 시간 범위가 저장 구간 안에 있으면 MongoDB 대신 여기서 처리한다.
+class HotStore {
+public:
+    // 숫자 메시지 통계 (평균은 값 > 0 인 로그만, 현재 값은 범위 내 최신 로그)
+    using NumericStats = stats_kernels::RangeAggregate;
+
+    struct DeviceMeta {
+        std::string device_name;
+        std::string location;
+    };
+
+    // 문자열 사전은 구간마다 따로 두고 구간과 함께 해제 (자유 형식 메시지가 계속 쌓이지 않음)
+    struct Partition {
+        StringDictionary devices;
+        std::vector<DeviceMeta> device_meta;
+        StringDictionary log_codes;
+        StringDictionary log_levels;
+        StringDictionary messages;
+
+        std::vector<int64_t> timestamp;
+        std::vector<uint32_t> device;
+        std::vector<uint32_t> log_code;
+        std::vector<uint32_t> log_level;
+        std::vector<uint8_t> severity;
+        std::vector<uint32_t> message;
+        std::vector<std::string> id;
+
+        // 숫자 측정값 (저장 정책 적용 전 원본, 통계 계산용)
+        std::vector<int64_t> sample_timestamp;
+        std::vector<uint32_t> sample_device;
+        std::vector<double> sample_value;
+
+        size_t size() const { return timestamp.size(); }
+    };
+
+private:
+    int64_t window_ms;
+    int64_t partition_ms;
+    int64_t coverage_start;  // 이 시각 이후 로그는 모두 저장되어 있음
+
+    mutable std::shared_mutex mutex;
+    std::map<int64_t, Partition> partitions;  // 구간 시작 시각 -> 구간
+    uint64_t dropped = 0;
+
+    static uint8_t encode_severity(const std::string& severity);
+    static const char* decode_severity(uint8_t code);
+
+    void evict_locked(int64_t now_ms);
+    json row_to_json(const Partition& part, size_t row) const;
+
+    // 필터 조건에 맞는 행 선택 (컬럼 단위 스캔)
+    // 구간 사전에 없는 값으로 필터링하면 false (구간에 결과 없음)
+    bool select_rows(const Partition& part, const LogFilter& filter, uint8_t severity,
+                     std::vector<uint32_t>& selection) const;
+
+public:
+    HotStore(const Config& cfg);
+
+    bool enabled() const { return window_ms > 0; }
+
+    // start 시각 이후 구간을 모두 보유하고 있는지
+    bool covers(int64_t start_time) const;
+
+    void append(const std::string& id,
+                const std::string& device_id,
+                const std::string& device_name,
+                const std::string& location,
+                const std::string& log_code,
+                const std::string& log_level,
+                const std::string& severity,
+                const std::string& message,
+                int64_t timestamp);
+
+    // 숫자 메시지 원본 값 기록 (저장 정책으로 저장되지 않는 값도 통계에 반영)
+    void record_sample(const std::string& device_id, const std::string& message, int64_t timestamp);
+
+    // 최신순 조회 (complete: 결과가 MongoDB 조회와 동일함이 보장되는지)
+    json find(const LogFilter& filter, int limit, bool& complete) const;
+
+    // 디바이스의 숫자 메시지 통계 (시간 범위 내, record_sample로 기록한 원본 값 기준)
+    NumericStats numeric_stats(const std::string& device_id, int64_t start_time, int64_t end_time) const;
+
+    json stats() const;
+};
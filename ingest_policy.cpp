@@ -0,0 +1,255 @@
+#include "ingest_policy.h"
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+#include "string_util.h"
+
+IngestPolicy::IngestPolicy(const Config& cfg) : config(cfg) {
+    std::lock_guard<std::mutex> lock(mutex);
+    reload_locked();
+}
+
+void IngestPolicy::reload_locked() {
+    // 설정 재적재(SIGHUP) 시 스냅샷이 바뀌면 규칙을 다시 읽음 (규칙이 그대로인 진행 중 상태는 유지)
+    loaded = config.tunables();
+    rules.clear();
+
+    // "KEY:opt=v,opt=v;KEY:..." 파싱
+    std::stringstream entries(loaded->ingest_policy);
+    std::string entry;
+    while (std::getline(entries, entry, ';')) {
+        entry = string_util::trim(entry);
+        size_t colon = entry.find(':');
+        if (entry.empty() || colon == std::string::npos) continue;
+
+        std::string key = string_util::trim(entry.substr(0, colon));
+        Rule rule;
+        std::stringstream options(entry.substr(colon + 1));
+        std::string option;
+        try {
+            while (std::getline(options, option, ',')) {
+                size_t eq = option.find('=');
+                if (eq == std::string::npos) continue;
+                std::string name = string_util::trim(option.substr(0, eq));
+                std::string value = string_util::trim(option.substr(eq + 1));
+                if (name == "deadband") rule.deadband = std::stod(value);
+                else if (name == "interval") rule.interval_ms = std::stoll(value);
+                else if (name == "window") rule.window_ms = std::stoll(value);
+                else std::cerr << "Unknown ingest policy option: " << name << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid ingest policy '" << entry << "': " << e.what() << std::endl;
+            continue;
+        }
+        rules[key] = rule;
+    }
+
+    if (!rules.empty()) {
+        std::cout << "Ingest policies loaded: " << rules.size() << std::endl;
+    }
+
+    // window 규칙이 없어지거나 구간 폭이 바뀐 스트림은 열린 구간을 이전 규칙으로 닫아 저장 대기
+    for (auto& [key, state] : states) {
+        if (state.windows.empty()) continue;
+        size_t slash = key.rfind('/');
+        const Rule* rule = find_rule(key.substr(0, slash), key.substr(slash + 1));
+        if (rule && rule->window_ms == state.rule.window_ms) continue;
+        close_windows(key, state, retired);
+    }
+    if (!retired.empty()) has_retired = true;
+}
+
+void IngestPolicy::close_windows(const std::string& key, State& state, std::vector<Pending>& out) {
+    size_t slash = key.rfind('/');
+    std::string device_id = key.substr(0, slash);
+    std::string log_code = key.substr(slash + 1);
+    for (auto& [window_start, window] : state.windows) {
+        if (window.revision > 0) continue;
+        out.push_back(Pending{device_id, window.log_level,
+                              window_record(log_code, state.rule, window_start, window)});
+        ++stored;
+        ++windows;
+    }
+    state.windows.clear();
+}
+
+const IngestPolicy::Rule* IngestPolicy::find_rule(const std::string& device_id, const std::string& log_code) const {
+    auto it = rules.find(device_id + "/" + log_code);
+    if (it != rules.end()) return &it->second;
+    it = rules.find(log_code);
+    return it != rules.end() ? &it->second : nullptr;
+}
+
+TelemetryRecord IngestPolicy::window_record(const std::string& log_code, const Rule& rule,
+                                            int64_t window_start, Window& window) {
+    double avg = window.sum / static_cast<double>(window.count);
+    ++window.revision;
+
+    TelemetryRecord record;
+    record.log_code = log_code;
+    record.timestamp = window.last_sample;
+    record.has_timestamp = true;
+    record.metadata = json::object();
+    record.metadata["aggregation"] = {
+        {"window_start", window_start},
+        {"window_end", window_start + rule.window_ms},
+        {"count", window.count},
+        {"min", window.min},
+        {"max", window.max},
+        {"avg", avg},
+        {"revision", window.revision}
+    };
+
+    // 숫자 메시지 스트림은 평균을 정수 메시지로 유지 (기존 통계 계산과 호환)
+    if (window.from_metadata) {
+        record.metadata["temperature"] = avg;
+        std::ostringstream message;
+        message << "window avg " << avg << " (min " << window.min << ", max " << window.max << ", n=" << window.count << ")";
+        record.message = message.str();
+    } else {
+        record.message = std::to_string(static_cast<int64_t>(std::llround(avg)));
+    }
+    return record;
+}
+
+void IngestPolicy::apply(const std::string& device_id,
+                         const std::string& log_level,
+                         const TelemetryRecord& record,
+                         int64_t timestamp,
+                         int64_t watermark,
+                         std::vector<TelemetryRecord>& out) {
+    double value = 0.0;
+    bool from_metadata = false;
+    bool numeric = string_util::parse_numeric(record.message, value);
+    if (!numeric && record.metadata.is_object() && record.metadata.contains("temperature") &&
+        record.metadata["temperature"].is_number()) {
+        value = record.metadata["temperature"].get<double>();
+        numeric = from_metadata = true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (config.tunables() != loaded) reload_locked();
+    ++received;
+
+    const Rule* rule = rules.empty() ? nullptr : find_rule(device_id, record.log_code);
+
+    if (!rule || !numeric || log_level == "error") {
+        out.push_back(record);
+        ++stored;
+        return;
+    }
+
+    State& state = states[device_id + "/" + record.log_code];
+    state.rule = *rule;
+
+    if (rule->window_ms > 0) {
+        int64_t window_start = timestamp - timestamp % rule->window_ms;
+        // 디바이스 최대 이벤트 시각 (워터마크가 없으면 이 로그 시각)
+        int64_t max_event_time = watermark == INT64_MIN ? timestamp : watermark + config.allowed_lateness_ms();
+
+        auto it = state.windows.find(window_start);
+        if (it == state.windows.end() && window_start + rule->window_ms <= watermark) {
+            // 허용 지연을 넘긴 구간 → 집계 없이 원본 저장
+            out.push_back(record);
+            ++stored;
+            ++late;
+        } else {
+            if (it == state.windows.end()) {
+                it = state.windows.emplace(window_start, Window{}).first;
+                it->second.log_level = log_level;
+                it->second.from_metadata = from_metadata;
+                it->second.min = it->second.max = value;
+            }
+            Window& window = it->second;
+            window.min = std::min(window.min, value);
+            window.max = std::max(window.max, value);
+            window.sum += value;
+            window.count += 1;
+            window.last_sample = std::max(window.last_sample, timestamp);
+
+            // 이미 저장한 구간에 늦게 도착한 로그 → 보정 집계 저장
+            if (window.revision > 0) {
+                out.push_back(window_record(record.log_code, *rule, window_start, window));
+                ++stored;
+                ++corrections;
+            } else {
+                ++suppressed;
+            }
+        }
+
+        // 디바이스 최대 이벤트 시각이 끝을 지난 구간은 저장, 워터마크가 지난 구간은 상태 제거
+        for (auto w = state.windows.begin(); w != state.windows.end();) {
+            int64_t window_end = w->first + rule->window_ms;
+            if (window_end > max_event_time) break;
+            if (w->second.revision == 0) {
+                out.push_back(window_record(record.log_code, *rule, w->first, w->second));
+                ++stored;
+                ++windows;
+            }
+            w = window_end <= watermark ? state.windows.erase(w) : std::next(w);
+        }
+        return;
+    }
+
+    // 순서가 바뀐 로그는 마지막 저장 값과 비교하지 않고 그대로 저장
+    if (state.has_last && timestamp < state.last_timestamp) {
+        out.push_back(record);
+        ++stored;
+        ++late;
+        return;
+    }
+
+    bool keep = true;
+    if (state.has_last && rule->deadband > 0.0 && std::fabs(value - state.last_value) < rule->deadband) {
+        keep = false;
+    }
+    if (state.has_last && rule->interval_ms > 0 && timestamp - state.last_timestamp < rule->interval_ms) {
+        keep = false;
+    }
+
+    if (!keep) {
+        ++suppressed;
+        return;
+    }
+
+    state.has_last = true;
+    state.last_value = value;
+    state.last_timestamp = timestamp;
+    out.push_back(record);
+    ++stored;
+}
+
+std::vector<IngestPolicy::Pending> IngestPolicy::take_retired() {
+    if (!has_retired) return {};
+    std::lock_guard<std::mutex> lock(mutex);
+    has_retired = false;
+    std::vector<Pending> result = std::move(retired);
+    retired.clear();
+    return result;
+}
+
+std::vector<IngestPolicy::Pending> IngestPolicy::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Pending> pending = std::move(retired);
+    retired.clear();
+    has_retired = false;
+
+    for (auto& [key, state] : states) {
+        if (!state.windows.empty()) close_windows(key, state, pending);
+    }
+    return pending;
+}
+
+json IngestPolicy::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    json result;
+    result["rules"] = rules.size();
+    result["received"] = received;
+    result["stored"] = stored;
+    result["suppressed"] = suppressed;
+    result["windows"] = windows;
+    result["corrections"] = corrections;
+    result["late"] = late;
+    return result;
+}
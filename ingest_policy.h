@@ -0,0 +1,105 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "config.h"
+#include "telemetry_record.h"
+
+using json = nlohmann::json;
+
+// 숫자 센서 로그 저장 정책 (MongoDB 저장 전 단계)
+// INGEST_POLICY="SPD:deadband=1,interval=500;TMP:window=60000;robot_arm_01/TMP:deadband=0.5"
+// - deadband: 마지막 저장 값과의 차이가 X 이상일 때만 저장
+// - interval: T ms 에 최대 한 건만 저장
+// - window:   W ms 구간마다 min/max/avg 집계 로그 한 건만 저장
+// 숫자 값은 메시지("^[0-9]+$") 또는 metadata.temperature에서 읽으며, 숫자가 아니거나 error 레벨이면 항상 저장한다.
+// 구간은 이벤트 시각(timestamp) 기준이다. 디바이스의 최대 이벤트 시각(EventClock)이 구간 끝을 지나면 구간 집계를 저장하되
+// 워터마크(최대 이벤트 시각 - ALLOWED_LATENESS_MS)가 지날 때까지 상태를 유지하고, 그 사이 늦게 도착한 로그는
+// 해당 구간에 더해 revision을 올린 보정 집계를 다시 저장한다.
+// 허용 지연을 넘긴 로그와 deadband/interval 규칙에서 순서가 바뀐 로그는 원본 그대로 저장한다.
+class IngestPolicy {
+public:
+    struct Rule {
+        double deadband = 0.0;
+        int64_t interval_ms = 0;
+        int64_t window_ms = 0;
+    };
+
+    // 종료 또는 규칙 변경으로 강제로 닫은 집계 구간
+    struct Pending {
+        std::string device_id;
+        std::string log_level;
+        TelemetryRecord record;
+    };
+
+private:
+    // 이벤트 시각 구간 집계
+    struct Window {
+        std::string log_level;
+        bool from_metadata = false;
+        int64_t last_sample = 0;     // 구간 내 최대 이벤트 시각
+        double min = 0.0;
+        double max = 0.0;
+        double sum = 0.0;
+        uint64_t count = 0;
+        uint32_t revision = 0;       // 저장한 횟수 (2 이상이면 보정 집계)
+    };
+
+    struct State {
+        bool has_last = false;
+        double last_value = 0.0;
+        int64_t last_timestamp = 0;
+
+        std::map<int64_t, Window> windows;   // 구간 시작 -> 집계 (저장 후 허용 지연 동안 유지)
+        Rule rule;                           // 열린 구간을 만든 규칙 (재적재로 규칙이 바뀌어도 이 규칙으로 닫음)
+    };
+
+    const Config& config;
+    std::shared_ptr<const Tunables> loaded;        // 규칙을 읽어 온 설정 스냅샷
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Rule> rules;   // "log_code" 또는 "device_id/log_code"
+    std::unordered_map<std::string, State> states; // "device_id/log_code"
+    uint64_t received = 0;
+    uint64_t stored = 0;
+    uint64_t suppressed = 0;
+    uint64_t windows = 0;
+    uint64_t corrections = 0;
+    uint64_t late = 0;          // 허용 지연 초과 또는 순서가 바뀌어 원본 그대로 저장
+
+    std::vector<Pending> retired;              // 재적재로 규칙이 바뀌어 닫은 구간 (take_retired로 가져감)
+    std::atomic<bool> has_retired{false};
+
+    void reload_locked();
+    // 구간 상태의 저장하지 않은 집계를 out에 추가하고 구간 상태 제거
+    void close_windows(const std::string& key, State& state, std::vector<Pending>& out);
+    const Rule* find_rule(const std::string& device_id, const std::string& log_code) const;
+    static TelemetryRecord window_record(const std::string& log_code, const Rule& rule,
+                                         int64_t window_start, Window& window);
+
+public:
+    IngestPolicy(const Config& cfg);
+
+    // 저장할 레코드를 out에 추가 (원본, 닫힌 구간의 집계 레코드, 또는 없음)
+    // watermark: 이 로그를 반영한 디바이스 워터마크 (EventClock::watermark)
+    void apply(const std::string& device_id,
+               const std::string& log_level,
+               const TelemetryRecord& record,
+               int64_t timestamp,
+               int64_t watermark,
+               std::vector<TelemetryRecord>& out);
+
+    // 규칙 재적재로 닫은 집계 구간 반환 (없으면 잠금 없이 빈 목록)
+    std::vector<Pending> take_retired();
+
+    // 아직 저장하지 않은 집계 구간을 모두 닫아 반환
+    std::vector<Pending> flush();
+
+    json stats();
+};
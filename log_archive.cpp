@@ -0,0 +1,134 @@
+#include "log_archive.h"
+#include <iostream>
+#include <map>
+#include <ctime>
+#include <cstring>
+#include <algorithm>
+#include <unordered_set>
+#include <filesystem>
+#include <zlib.h>
+#include <bsoncxx/document/view.hpp>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr const char* DAY_FILE_SUFFIX = ".bson.gz";
+
+// UTC 날짜 (YYYY-MM-DD, 문자열 비교 순서 = 날짜 순서)
+std::string day_name(int64_t timestamp) {
+    time_t seconds = static_cast<time_t>(timestamp / 1000);
+    char date_buf[12];
+    strftime(date_buf, sizeof(date_buf), "%Y-%m-%d", std::gmtime(&seconds));
+    return date_buf;
+}
+
+int64_t doc_timestamp(const bsoncxx::document::view& view) {
+    auto element = view["timestamp"];
+    if (element && element.type() == bsoncxx::type::k_int64) return element.get_int64().value;
+    return 0;
+}
+}
+
+LogArchive::LogArchive(const Config& cfg) : config(cfg), archive_dir(cfg.archive_dir()) {}
+
+std::string LogArchive::day_file(const std::string& collection, int64_t timestamp) const {
+    return archive_dir + "/" + collection + "/" + day_name(timestamp) + DAY_FILE_SUFFIX;
+}
+
+bool LogArchive::append(const std::string& collection, const std::vector<bsoncxx::document::value>& docs) {
+    if (docs.empty()) return true;
+
+    // 일별 파일로 분류
+    std::map<std::string, std::vector<bsoncxx::document::view>> by_file;
+    for (const auto& doc : docs) {
+        auto view = doc.view();
+        by_file[day_file(collection, doc_timestamp(view))].push_back(view);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+        fs::create_directories(archive_dir + "/" + collection);
+    } catch (const std::exception& e) {
+        std::cerr << "Error creating archive directory: " << e.what() << std::endl;
+        return false;
+    }
+
+    for (const auto& [path, views] : by_file) {
+        // gzip 멤버 단위로 이어 붙임 (gzread는 연속된 멤버를 그대로 읽음)
+        gzFile file = gzopen(path.c_str(), "ab");
+        if (!file) {
+            std::cerr << "Error opening archive file: " << path << std::endl;
+            return false;
+        }
+        bool ok = true;
+        for (const auto& view : views) {
+            if (gzwrite(file, view.data(), static_cast<unsigned>(view.length())) != static_cast<int>(view.length())) {
+                ok = false;
+                break;
+            }
+        }
+        if (gzclose(file) != Z_OK || !ok) {
+            std::cerr << "Error writing archive file: " << path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+json LogArchive::scan(const std::string& collection, const LogFilter& filter, int limit) const {
+    json data_array = json::array();
+    if (!enabled() || !filter.has_time_range || limit <= 0) return data_array;
+
+    std::vector<json> matched;
+    std::unordered_set<std::string> seen_ids;
+    std::vector<uint8_t> buffer;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // 디렉터리를 한 번만 나열해 범위가 겹치는 날짜의 파일만 최신 날짜부터 스캔
+    const std::string first_day = day_name(filter.start_time);
+    const std::string last_day = day_name(filter.end_time);
+    const size_t suffix_length = std::strlen(DAY_FILE_SUFFIX);
+    std::vector<std::string> paths;
+    std::error_code ec;
+    for (fs::directory_iterator it(archive_dir + "/" + collection, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.size() != first_day.size() + suffix_length ||
+            name.compare(first_day.size(), suffix_length, DAY_FILE_SUFFIX) != 0) continue;
+        std::string day = name.substr(0, first_day.size());
+        if (day < first_day || day > last_day) continue;
+        paths.push_back(it->path().string());
+    }
+    std::sort(paths.rbegin(), paths.rend());
+
+    for (const auto& path : paths) {
+        gzFile file = gzopen(path.c_str(), "rb");
+        if (!file) continue;
+
+        while (true) {
+            int32_t length = 0;
+            if (gzread(file, &length, sizeof(length)) != static_cast<int>(sizeof(length)) || length < 5) break;
+
+            buffer.resize(static_cast<size_t>(length));
+            std::memcpy(buffer.data(), &length, sizeof(length));
+            int remaining = length - static_cast<int>(sizeof(length));
+            if (gzread(file, buffer.data() + sizeof(length), remaining) != remaining) break;
+
+            bsoncxx::document::view view(buffer.data(), buffer.size());
+            if (!filter.matches(view)) continue;
+            // 보관 후 삭제 전에 중단되면 다음 실행에서 같은 문서를 다시 보관하므로 _id 중복 제거 (limit 적용 전)
+            json row = log_document_to_json(view);
+            if (seen_ids.insert(row.value("_id", "")).second) {
+                matched.push_back(std::move(row));
+            }
+        }
+        gzclose(file);
+    }
+
+    std::sort(matched.begin(), matched.end(), [](const json& a, const json& b) {
+        return a.value("timestamp", int64_t{0}) > b.value("timestamp", int64_t{0});
+    });
+    if (matched.size() > static_cast<size_t>(limit)) matched.resize(limit);
+
+    for (auto& item : matched) data_array.push_back(std::move(item));
+    return data_array;
+}
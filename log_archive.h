@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <bsoncxx/document/value.hpp>
+#include "config.h"
+#include "log_filter.h"
+
+using json = nlohmann::json;
+
+// 보존 기간이 지난 로그의 로컬 아카이브
+// {ARCHIVE_DIR}/{collection}/{YYYY-MM-DD}.bson.gz (일 단위, gzip 압축된 BSON 문서 연속 저장)
+class LogArchive {
+private:
+    const Config& config;
+    std::string archive_dir;
+    mutable std::mutex mutex;
+
+    std::string day_file(const std::string& collection, int64_t timestamp) const;
+
+public:
+    LogArchive(const Config& cfg);
+
+    bool enabled() const { return config.archive_enabled(); }
+
+    // 문서를 timestamp 기준 일별 파일에 추가 (기록 완료 후 true)
+    bool append(const std::string& collection, const std::vector<bsoncxx::document::value>& docs);
+
+    // 시간 범위가 겹치는 일별 파일만 스캔 (최신순, 최대 limit개)
+    json scan(const std::string& collection, const LogFilter& filter, int limit) const;
+};
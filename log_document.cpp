@@ -0,0 +1,46 @@
+#include "log_document.h"
+#include <ctime>
+#include <bsoncxx/builder/stream/document.hpp>
+#include <bsoncxx/json.hpp>
+#include <bsoncxx/types.hpp>
+
+std::string make_log_stream(const std::string& device_id,
+                            const std::string& log_level,
+                            std::chrono::system_clock::time_point now) {
+    time_t now_time_t = std::chrono::system_clock::to_time_t(now);
+    char time_buf[12];
+    strftime(time_buf, sizeof(time_buf), "%Y/%m/%d", std::gmtime(&now_time_t));
+    return device_id + "/" + time_buf + "/" + log_level;
+}
+
+bsoncxx::document::value build_log_document(const std::string& structured_id,
+                                            const std::string& device_id,
+                                            const std::string& log_level,
+                                            const std::string& log_stream,
+                                            const std::string& topic,
+                                            const DeviceContext& device,
+                                            const TelemetryRecord& record,
+                                            const std::string& severity,
+                                            int64_t timestamp,
+                                            int64_t ingestion_time) {
+    bsoncxx::builder::stream::document builder;
+    builder << "_id" << structured_id
+            << "log_group" << device.log_group
+            << "log_stream" << log_stream
+            << "device_id" << device_id
+            << "device_name" << device.device_name
+            << "device_type" << device.device_type
+            << "location" << device.location
+            << "log_code" << record.log_code
+            << "severity" << severity
+            << "log_level" << log_level
+            << "message" << record.message
+            << "timestamp" << bsoncxx::types::b_int64{timestamp}
+            << "ingestion_time" << bsoncxx::types::b_int64{ingestion_time}
+            << "topic" << topic;
+
+    if (record.metadata.is_object()) {
+        builder << "metadata" << bsoncxx::from_json(record.metadata.dump());
+    }
+    return builder.extract();
+}
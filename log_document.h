@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <bsoncxx/document/value.hpp>
+#include "device_context.h"
+#include "telemetry_record.h"
+
+// 그룹 컬렉션 / logs_all에 저장하는 로그 문서 구성
+// 저장 경로와 벤치마크가 같은 코드를 쓰도록 DatabaseManager에서 분리
+
+// {device_id}/{YYYY/MM/DD}/{log_level} (UTC 날짜)
+std::string make_log_stream(const std::string& device_id,
+                            const std::string& log_level,
+                            std::chrono::system_clock::time_point now);
+
+bsoncxx::document::value build_log_document(const std::string& structured_id,
+                                            const std::string& device_id,
+                                            const std::string& log_level,
+                                            const std::string& log_stream,
+                                            const std::string& topic,
+                                            const DeviceContext& device,
+                                            const TelemetryRecord& record,
+                                            const std::string& severity,
+                                            int64_t timestamp,
+                                            int64_t ingestion_time);
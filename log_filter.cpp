@@ -0,0 +1,95 @@
+#include "log_filter.h"
+#include <bsoncxx/builder/stream/document.hpp>
+#include <bsoncxx/types.hpp>
+
+using bson_builder = bsoncxx::builder::stream::document;
+using bsoncxx::builder::stream::finalize;
+
+namespace {
+std::string string_field(const bsoncxx::document::view& view, const char* key) {
+    auto element = view[key];
+    if (!element || element.type() != bsoncxx::type::k_string) return "";
+    return std::string(element.get_string().value);
+}
+
+std::string string_filter(const json& filters, const char* key) {
+    if (filters.contains(key) && !filters[key].empty()) {
+        return filters[key].get<std::string>();
+    }
+    return "";
+}
+}
+
+LogFilter LogFilter::from_json(const json& filters) {
+    LogFilter filter;
+    if (!filters.is_object()) return filter;
+
+    filter.device_id = string_filter(filters, "device_id");
+    filter.log_level = string_filter(filters, "log_level");
+    filter.log_code = string_filter(filters, "log_code");
+    filter.severity = string_filter(filters, "severity");
+
+    if (filters.contains("time_range")) {
+        const auto& time_range = filters["time_range"];
+        if (time_range.contains("start") && time_range.contains("end")) {
+            filter.has_time_range = true;
+            filter.start_time = time_range["start"];
+            filter.end_time = time_range["end"];
+        }
+    }
+    return filter;
+}
+
+bsoncxx::document::value LogFilter::to_bson() const {
+    bson_builder builder;
+
+    if (!device_id.empty()) builder << "device_id" << device_id;
+    if (!log_level.empty()) builder << "log_level" << log_level;
+    if (!log_code.empty()) builder << "log_code" << log_code;
+    if (!severity.empty()) builder << "severity" << severity;
+
+    if (has_time_range) {
+        builder << "timestamp" << bsoncxx::builder::stream::open_document
+                << "$gte" << bsoncxx::types::b_int64{start_time}
+                << "$lte" << bsoncxx::types::b_int64{end_time}
+                << bsoncxx::builder::stream::close_document;
+    }
+
+    return builder << finalize;
+}
+
+bool LogFilter::matches(const std::string& log_device_id,
+                        const std::string& log_log_level,
+                        const std::string& log_log_code,
+                        const std::string& log_severity,
+                        int64_t timestamp) const {
+    if (!device_id.empty() && device_id != log_device_id) return false;
+    if (!log_level.empty() && log_level != log_log_level) return false;
+    if (!log_code.empty() && log_code != log_log_code) return false;
+    if (!severity.empty() && severity != log_severity) return false;
+    if (has_time_range && (timestamp < start_time || timestamp > end_time)) return false;
+    return true;
+}
+
+bool LogFilter::matches(const bsoncxx::document::view& log_doc) const {
+    auto timestamp = log_doc["timestamp"];
+    return matches(string_field(log_doc, "device_id"),
+                   string_field(log_doc, "log_level"),
+                   string_field(log_doc, "log_code"),
+                   string_field(log_doc, "severity"),
+                   timestamp && timestamp.type() == bsoncxx::type::k_int64 ? timestamp.get_int64().value : 0);
+}
+
+json log_document_to_json(const bsoncxx::document::view& view) {
+    json log_item;
+    if (view["_id"]) log_item["_id"] = std::string(view["_id"].get_string().value);
+    if (view["device_id"]) log_item["device_id"] = std::string(view["device_id"].get_string().value);
+    if (view["device_name"]) log_item["device_name"] = std::string(view["device_name"].get_string().value);
+    if (view["log_level"]) log_item["log_level"] = std::string(view["log_level"].get_string().value);
+    if (view["log_code"]) log_item["log_code"] = std::string(view["log_code"].get_string().value);
+    if (view["severity"]) log_item["severity"] = std::string(view["severity"].get_string().value);
+    if (view["message"]) log_item["message"] = std::string(view["message"].get_string().value);
+    if (view["location"]) log_item["location"] = std::string(view["location"].get_string().value);
+    if (view["timestamp"]) log_item["timestamp"] = view["timestamp"].get_int64().value;
+    return log_item;
+}
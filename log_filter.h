@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <bsoncxx/document/value.hpp>
+#include <bsoncxx/document/view.hpp>
+
+using json = nlohmann::json;
+
+// 로그 조회/구독 공용 필터 (query 요청의 filters 객체)
+struct LogFilter {
+    std::string device_id;
+    std::string log_level;
+    std::string log_code;
+    std::string severity;
+
+    bool has_time_range = false;
+    int64_t start_time = 0;
+    int64_t end_time = 0;
+
+    // filters JSON 파싱 (빈 값은 조건 없음으로 처리)
+    static LogFilter from_json(const json& filters);
+
+    // MongoDB find 필터로 변환
+    bsoncxx::document::value to_bson() const;
+
+    // 수신된 로그가 필터 조건에 맞는지 확인 (DB 조회 없이 메모리에서 판단)
+    bool matches(const std::string& log_device_id,
+                 const std::string& log_log_level,
+                 const std::string& log_log_code,
+                 const std::string& log_severity,
+                 int64_t timestamp) const;
+
+    // 저장된 로그 문서가 필터 조건에 맞는지 확인 (아카이브 스캔용)
+    bool matches(const bsoncxx::document::view& log_doc) const;
+};
+
+// 로그 문서를 조회 응답용 JSON으로 변환
+json log_document_to_json(const bsoncxx::document::view& view);
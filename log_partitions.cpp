@@ -0,0 +1,136 @@
+#include "log_partitions.h"
+#include <ctime>
+#include <cstdio>
+#include <chrono>
+#include <cctype>
+
+namespace {
+constexpr int64_t DAY_MS = 24LL * 60 * 60 * 1000;
+
+int64_t utc_ms(int year, int month, int day) {
+    std::tm tm{};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    return static_cast<int64_t>(timegm(&tm)) * 1000;
+}
+
+// "2026_10" / "2026_10_18" 형식 확인 후 숫자 추출
+bool parse_suffix(const std::string& suffix, int& year, int& month, int& day) {
+    if (suffix.size() != 7 && suffix.size() != 10) return false;
+    for (size_t i = 0; i < suffix.size(); ++i) {
+        bool separator = i == 4 || i == 7;
+        if (separator ? suffix[i] != '_' : !std::isdigit(static_cast<unsigned char>(suffix[i]))) return false;
+    }
+    year = std::stoi(suffix.substr(0, 4));
+    month = std::stoi(suffix.substr(5, 2));
+    day = suffix.size() == 10 ? std::stoi(suffix.substr(8, 2)) : 0;
+    return month >= 1 && month <= 12 && (suffix.size() == 7 || (day >= 1 && day <= 31));
+}
+}
+
+LogPartitions::LogPartitions(const Config& cfg) : config(cfg) {
+    const auto& mode = cfg.log_partition();
+    granularity = mode == "day" ? Granularity::DAY : mode == "month" ? Granularity::MONTH : Granularity::NONE;
+}
+
+std::string LogPartitions::collection_for(int64_t timestamp_ms) const {
+    if (!enabled()) return config.all_logs_collection();
+
+    std::time_t seconds = static_cast<std::time_t>(timestamp_ms / 1000);
+    std::tm tm{};
+    gmtime_r(&seconds, &tm);
+    char suffix[16];
+    if (granularity == Granularity::DAY) {
+        std::snprintf(suffix, sizeof(suffix), "_%04d_%02d_%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    } else {
+        std::snprintf(suffix, sizeof(suffix), "_%04d_%02d", tm.tm_year + 1900, tm.tm_mon + 1);
+    }
+    return config.all_logs_collection() + suffix;
+}
+
+std::string LogPartitions::route(const std::string& collection, const bsoncxx::document::view& doc) const {
+    if (!enabled() || collection != config.all_logs_collection()) return collection;
+
+    auto element = doc["timestamp"];
+    int64_t timestamp = 0;
+    if (element && element.type() == bsoncxx::type::k_int64) {
+        timestamp = element.get_int64().value;
+    } else if (element && element.type() == bsoncxx::type::k_int32) {
+        timestamp = element.get_int32().value;
+    } else {
+        timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    return collection_for(timestamp);
+}
+
+bool LogPartitions::range_of(const std::string& name, int64_t& begin, int64_t& end) const {
+    const std::string prefix = config.all_logs_collection() + "_";
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) return false;
+
+    int year = 0, month = 0, day = 0;
+    if (!parse_suffix(name.substr(prefix.size()), year, month, day)) return false;
+
+    // 설정을 month ↔ day로 바꿔도 이전 형식의 파티션을 계속 읽을 수 있도록 두 형식 모두 인식
+    if (day > 0) {
+        begin = utc_ms(year, month, day);
+        end = begin + DAY_MS;
+    } else {
+        begin = utc_ms(year, month, 1);
+        end = month == 12 ? utc_ms(year + 1, 1, 1) : utc_ms(year, month + 1, 1);
+    }
+    return true;
+}
+
+std::vector<std::string> LogPartitions::select(bool has_range, int64_t start_time, int64_t end_time) const {
+    if (!enabled()) return {config.all_logs_collection()};
+
+    std::vector<std::string> result;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = known.rbegin(); it != known.rend(); ++it) {
+        int64_t begin = 0, end = 0;
+        if (!range_of(*it, begin, end)) continue;
+        if (!has_range || (begin <= end_time && end > start_time)) result.push_back(*it);
+    }
+    if (has_legacy) result.push_back(config.all_logs_collection());
+    return result;
+}
+
+void LogPartitions::refresh(const std::vector<std::string>& collections) {
+    if (!enabled()) return;
+
+    std::set<std::string> found;
+    bool legacy = false;
+    int64_t begin = 0, end = 0;
+    for (const auto& name : collections) {
+        if (name == config.all_logs_collection()) legacy = true;
+        else if (range_of(name, begin, end)) found.insert(name);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    known = std::move(found);
+    has_legacy = legacy;
+}
+
+void LogPartitions::note(const std::string& name) {
+    if (!enabled() || name == config.all_logs_collection()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    known.insert(name);
+}
+
+void LogPartitions::forget(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    known.erase(name);
+}
+
+json LogPartitions::stats() const {
+    json result;
+    result["mode"] = config.log_partition();
+    std::lock_guard<std::mutex> lock(mutex);
+    result["partitions"] = known.size();
+    result["oldest"] = known.empty() ? "" : *known.begin();
+    result["newest"] = known.empty() ? "" : *known.rbegin();
+    result["legacy"] = has_legacy;
+    return result;
+}
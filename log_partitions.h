@@ -0,0 +1,51 @@
+#pragma once
+#include <set>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <bsoncxx/document/view.hpp>
+#include "config.h"
+
+using json = nlohmann::json;
+
+// logs_all 시간 파티션 (LOG_PARTITION=day / month)
+// 로그는 문서 timestamp(UTC) 기준 logs_all_YYYY_MM(_DD) 컬렉션에 저장하고, 조회/통계는 시간 범위와
+// 겹치는 파티션만 읽는다. 보존 기간 정리는 구간 전체가 만료된 파티션을 컬렉션째 삭제한다.
+// 존재하는 파티션 목록은 시작/정리 주기마다 MongoDB에서 다시 읽고, 저장 시 새 파티션을 추가한다.
+class LogPartitions {
+private:
+    enum class Granularity { NONE, DAY, MONTH };
+
+    const Config& config;
+    Granularity granularity;
+
+    mutable std::mutex mutex;
+    std::set<std::string> known;      // 이름순 = 시간순
+    bool has_legacy = false;          // 파티션 도입 전 logs_all에 남은 데이터
+
+public:
+    LogPartitions(const Config& cfg);
+
+    bool enabled() const { return granularity != Granularity::NONE; }
+
+    // timestamp가 속한 컬렉션 (비활성화면 logs_all)
+    std::string collection_for(int64_t timestamp_ms) const;
+
+    // 저장할 컬렉션 결정 (logs_all만 문서 timestamp 기준으로 나누고 나머지는 그대로)
+    std::string route(const std::string& collection, const bsoncxx::document::view& doc) const;
+
+    // 파티션 이름 → [begin, end) 구간 (파티션 이름이 아니면 false)
+    bool range_of(const std::string& name, int64_t& begin, int64_t& end) const;
+
+    // 시간 범위와 겹치는 컬렉션 (최신순, 범위가 없으면 전체, 파티션 도입 전 logs_all은 마지막)
+    std::vector<std::string> select(bool has_range, int64_t start_time, int64_t end_time) const;
+
+    // 존재하는 컬렉션 목록 반영 / 새로 저장한 파티션 추가 / 삭제한 파티션 제거
+    void refresh(const std::vector<std::string>& collections);
+    void note(const std::string& name);
+    void forget(const std::string& name);
+
+    json stats() const;
+};
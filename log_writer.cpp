@@ -0,0 +1,252 @@
+#include "log_writer.h"
+#include <map>
+#include <iostream>
+#include <algorithm>
+#include <mongocxx/client.hpp>
+#include <mongocxx/uri.hpp>
+
+namespace {
+constexpr auto THROUGHPUT_WINDOW = std::chrono::seconds(10);
+constexpr double LATENCY_EWMA_ALPHA = 0.2;
+}
+
+BatchController::BatchController(const Config& cfg)
+    : batch_min(static_cast<size_t>(cfg.log_writer_batch_min())),
+      batch_max(static_cast<size_t>(cfg.log_writer_batch_max())),
+      batch_step(static_cast<size_t>(cfg.log_writer_batch_step())),
+      flush_min_ms(cfg.log_writer_flush_min_ms()),
+      flush_max_ms(cfg.log_writer_flush_max_ms()),
+      target_latency_ms(cfg.log_writer_target_latency_ms()),
+      batch(batch_min),
+      interval_ms(flush_min_ms) {}
+
+void BatchController::observe(size_t documents, int64_t latency_ms, bool ok, bool filled, size_t backlog) {
+    // 배치 크기: 지연 초과/실패 시 절반, 여유가 있고 더 모을 수 있으면 BATCH_STEP 증가
+    if (!ok || latency_ms > target_latency_ms) {
+        size_t next = std::max(batch_min, batch / 2);
+        if (next != batch) ++decreases;
+        batch = next;
+    } else if (filled || backlog >= batch) {
+        size_t next = std::min(batch_max, batch + batch_step);
+        if (next != batch) ++increases;
+        batch = next;
+    }
+
+    // flush 간격: 밀려 있거나 거의 빈 배치면 절반, 시간이 다 됐을 때 반 이상 찼으면 증가
+    if (filled || backlog > 0 || documents * 2 < batch) {
+        interval_ms = std::max(flush_min_ms, interval_ms / 2);
+    } else {
+        interval_ms = std::min(flush_max_ms, interval_ms + flush_min_ms);
+    }
+}
+
+json BatchController::stats() const {
+    json result;
+    result["batch_size"] = batch;
+    result["flush_interval_ms"] = interval_ms;
+    result["target_latency_ms"] = target_latency_ms;
+    result["increases"] = increases;
+    result["decreases"] = decreases;
+    return result;
+}
+
+LogWriter::LogWriter(const Config& cfg, LogPartitions& log_partitions)
+    : config(cfg), partitions(log_partitions), controller(cfg) {}
+
+LogWriter::~LogWriter() {
+    drain(Clock::now());
+}
+
+void LogWriter::start() {
+    if (!enabled()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running) return;
+        running = true;
+    }
+    worker = std::thread(&LogWriter::run, this);
+    std::cout << "Async log writer enabled: batch " << config.log_writer_batch_min() << "-"
+              << config.log_writer_batch_max() << ", flush " << config.log_writer_flush_min_ms() << "-"
+              << config.log_writer_flush_max_ms() << " ms, target latency "
+              << config.log_writer_target_latency_ms() << " ms" << std::endl;
+}
+
+bool LogWriter::enqueue(std::vector<std::string>&& collections,
+                        std::vector<bsoncxx::document::value>&& documents,
+                        const std::string& log_level,
+                        Callback on_written) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return false;
+        if (queued_documents + documents.size() > static_cast<size_t>(config.log_writer_queue_max())) {
+            ++overflowed;
+            return false;
+        }
+        queued_documents += documents.size();
+        queue.push_back(Entry{std::move(collections), std::move(documents), log_level,
+                              std::move(on_written), Clock::now()});
+    }
+    cv.notify_one();
+    return true;
+}
+
+LogWriter::DrainResult LogWriter::drain(Clock::time_point deadline) {
+    DrainResult result;
+    uint64_t flushed_before = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!running) return result;
+        running = false;
+        flushed_before = flushed_documents;
+        cv.notify_all();
+
+        idle_cv.wait_until(lock, deadline, [this] { return queue.empty() && !writing; });
+        result.abandoned = queued_documents;
+        queue.clear();
+        queued_documents = 0;
+    }
+
+    // 기록 중인 배치는 끝날 때까지 기다림
+    if (worker.joinable()) worker.join();
+    std::lock_guard<std::mutex> lock(mutex);
+    result.flushed = static_cast<size_t>(flushed_documents - flushed_before);
+    return result;
+}
+
+void LogWriter::run() {
+    // mongocxx::client는 스레드 간 공유 불가 → 전용 연결 사용
+    mongocxx::client client{mongocxx::uri{config.mongo_uri()}};
+    CollectionHandles handles(client, config);
+
+    while (true) {
+        std::vector<Entry> batch;
+        size_t documents = 0;
+        bool filled = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return !running || !queue.empty(); });
+            if (queue.empty()) return;  // 종료 요청 + 큐 비움
+
+            // 가장 오래된 문서가 flush 간격을 넘기거나 배치가 찰 때까지 대기 (종료 중이면 바로 기록)
+            auto due = queue.front().queued_at + std::chrono::milliseconds(controller.flush_interval_ms());
+            filled = cv.wait_until(lock, due, [this] {
+                return !running || queued_documents >= controller.batch_size();
+            }) && queued_documents >= controller.batch_size();
+            if (queue.empty()) continue;
+
+            while (!queue.empty() && (batch.empty() || documents < controller.batch_size())) {
+                documents += queue.front().documents.size();
+                queued_documents -= queue.front().documents.size();
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+            writing = true;
+        }
+
+        bool ok = true;
+        auto started = Clock::now();
+        size_t written = write(handles, batch, ok);
+        auto finished = Clock::now();
+        int64_t latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(finished - started).count();
+
+        size_t backlog = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            backlog = queued_documents;
+            controller.observe(documents, latency_ms, ok, filled, backlog);
+
+            ++flushes;
+            flushed_documents += written;
+            failed_documents += documents - written;
+            last_latency_ms = latency_ms;
+            max_latency_ms = std::max(max_latency_ms, latency_ms);
+            avg_latency_ms = flushes == 1 ? latency_ms
+                                          : avg_latency_ms + LATENCY_EWMA_ALPHA * (latency_ms - avg_latency_ms);
+            recent.emplace_back(finished, written);
+            while (!recent.empty() && finished - recent.front().first > THROUGHPUT_WINDOW) recent.pop_front();
+        }
+
+        // 캐시 무효화 등 기록 후 처리 (잠금 밖에서)
+        for (auto& entry : batch) {
+            if (!entry.on_written) continue;
+            try {
+                entry.on_written();
+            } catch (const std::exception& e) {
+                std::cerr << "Log writer callback error: " << e.what() << std::endl;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        writing = false;
+        if (queue.empty()) idle_cv.notify_all();
+    }
+}
+
+size_t LogWriter::write(CollectionHandles& handles, std::vector<Entry>& batch, bool& ok) {
+    // 컬렉션(logs_all은 timestamp 파티션) / write concern(레벨) 단위로 묶어 insert_many 한 번씩
+    struct Group {
+        std::vector<bsoncxx::document::view> documents;
+        std::vector<size_t> entries;
+    };
+    std::map<std::pair<std::string, std::string>, Group> groups;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const auto& entry = batch[i];
+        std::string level = entry.log_level == "debug" ? entry.log_level : std::string();
+        for (const auto& name : entry.collections) {
+            for (const auto& doc : entry.documents) {
+                auto& group = groups[{partitions.route(name, doc.view()), level}];
+                group.documents.push_back(doc.view());
+                if (group.entries.empty() || group.entries.back() != i) group.entries.push_back(i);
+            }
+        }
+    }
+
+    std::vector<bool> failed(batch.size(), false);
+    for (const auto& [key, group] : groups) {
+        try {
+            handles.collection(key.first).insert_many(group.documents, handles.insert_options(key.second));
+            partitions.note(key.first);
+        } catch (const std::exception& e) {
+            std::cerr << "Error writing " << group.documents.size() << " logs to " << key.first
+                      << ": " << e.what() << std::endl;
+            ok = false;
+            for (size_t i : group.entries) failed[i] = true;
+        }
+    }
+
+    // 일부 컬렉션에만 기록된 요청은 실패로 집계하고 후처리하지 않음
+    size_t written = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (failed[i]) {
+            batch[i].on_written = nullptr;
+        } else {
+            written += batch[i].documents.size();
+        }
+    }
+    return written;
+}
+
+json LogWriter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    json result = controller.stats();
+    result["enabled"] = enabled();
+    result["queue_depth"] = queued_documents;
+    result["queue_max"] = config.log_writer_queue_max();
+    result["flushes"] = flushes;
+    result["flushed"] = flushed_documents;
+    result["failed"] = failed_documents;
+    result["overflowed"] = overflowed.load();
+    result["last_latency_ms"] = last_latency_ms;
+    result["avg_latency_ms"] = avg_latency_ms;
+    result["max_latency_ms"] = max_latency_ms;
+
+    // 최근 THROUGHPUT_WINDOW 동안 기록한 문서 수 기준
+    auto now = Clock::now();
+    size_t recent_documents = 0;
+    for (const auto& [at, count] : recent) {
+        if (now - at <= THROUGHPUT_WINDOW) recent_documents += count;
+    }
+    result["throughput_docs_per_sec"] =
+        static_cast<double>(recent_documents) / std::chrono::duration<double>(THROUGHPUT_WINDOW).count();
+    return result;
+}
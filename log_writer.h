@@ -0,0 +1,123 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+#include <nlohmann/json.hpp>
+#include <bsoncxx/document/value.hpp>
+#include "config.h"
+#include "collection_handles.h"
+#include "log_partitions.h"
+
+using json = nlohmann::json;
+
+// 로그 기록 배치 크기 / flush 간격 조정 (AIMD)
+// 삽입 지연이 목표 이하이고 배치가 가득 차거나 밀려 있으면 배치를 BATCH_STEP씩 늘리고,
+// 목표를 넘거나 삽입이 실패하면 절반으로 줄인다.
+// flush 간격은 배치가 반 이상 찬 채로 시간이 다 되면 늘리고 (기다리면 더 모임),
+// 거의 빈 배치거나 큐가 밀려 있으면 절반으로 줄인다 (야간에는 지연 우선).
+class BatchController {
+private:
+    size_t batch_min;
+    size_t batch_max;
+    size_t batch_step;
+    int64_t flush_min_ms;
+    int64_t flush_max_ms;
+    int64_t target_latency_ms;
+
+    size_t batch;
+    int64_t interval_ms;
+    uint64_t increases = 0;
+    uint64_t decreases = 0;
+
+public:
+    BatchController(const Config& cfg);
+
+    size_t batch_size() const { return batch; }
+    int64_t flush_interval_ms() const { return interval_ms; }
+
+    // 한 번의 기록 결과 반영 (filled: 배치가 차서 기록, backlog: 기록 후 남은 큐 문서 수)
+    void observe(size_t documents, int64_t latency_ms, bool ok, bool filled, size_t backlog);
+
+    json stats() const;
+};
+
+// 로그 문서 비동기 배치 기록 스레드 (LOG_WRITER_ASYNC=true 인 경우)
+// 수신 스레드는 문서를 큐에 넣기만 하고, 기록 스레드가 자기 연결로 컬렉션별 insert_many를 한 번에 수행한다.
+// 큐가 LOG_WRITER_QUEUE_MAX를 넘으면 enqueue가 false를 반환하고 호출한 쪽이 직접 삽입한다.
+class LogWriter {
+public:
+    using Callback = std::function<void()>;
+
+    // 종료 시 큐 처리 결과 (문서 수)
+    struct DrainResult {
+        size_t flushed = 0;
+        size_t abandoned = 0;
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 같은 문서를 여러 컬렉션(그룹 + logs_all)에 기록하는 한 건의 요청
+    struct Entry {
+        std::vector<std::string> collections;
+        std::vector<bsoncxx::document::value> documents;
+        std::string log_level;
+        Callback on_written;
+        Clock::time_point queued_at;
+    };
+
+    const Config& config;
+    LogPartitions& partitions;
+    BatchController controller;
+
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable idle_cv;   // 큐가 비고 기록 중인 배치가 없을 때
+    std::deque<Entry> queue;
+    size_t queued_documents = 0;
+    bool writing = false;
+    bool running = false;
+
+    // 통계 (mutex 보호)
+    uint64_t flushes = 0;
+    uint64_t flushed_documents = 0;
+    uint64_t failed_documents = 0;
+    int64_t last_latency_ms = 0;
+    double avg_latency_ms = 0.0;
+    int64_t max_latency_ms = 0;
+    std::deque<std::pair<Clock::time_point, size_t>> recent;   // 최근 처리량 계산용
+    std::atomic<uint64_t> overflowed{0};
+
+    void run();
+
+    // 한 배치 기록 (컬렉션/레벨별 insert_many), 기록 성공한 문서 수
+    size_t write(CollectionHandles& handles, std::vector<Entry>& batch, bool& ok);
+
+public:
+    LogWriter(const Config& cfg, LogPartitions& log_partitions);
+    ~LogWriter();
+
+    bool enabled() const { return config.log_writer_async(); }
+
+    void start();
+
+    // 큐에 추가 (기록 스레드가 없거나 큐가 가득 차면 false, 인자는 그대로 두므로 호출한 쪽이 직접 삽입)
+    // on_written은 모든 컬렉션에 기록된 뒤 기록 스레드에서 호출
+    bool enqueue(std::vector<std::string>&& collections,
+                 std::vector<bsoncxx::document::value>&& documents,
+                 const std::string& log_level,
+                 Callback on_written);
+
+    // 새 기록을 받지 않고 deadline까지 큐를 비운 뒤 종료 (넘으면 남은 문서는 버림)
+    DrainResult drain(Clock::time_point deadline);
+
+    json stats() const;
+};
@@ -1,6 +1,11 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <csignal>
+#include <filesystem>
 #include <mongocxx/instance.hpp>
 #include <mongocxx/client.hpp>
 #include <mongocxx/uri.hpp>
@@ -8,13 +13,51 @@
 #include "config.h"
 #include "database_manager.h"
 #include "mqtt_handler.h"
+#include "retention_manager.h"
+#include "request_worker_pool.h"
+
+namespace {
+// SIGHUP 수신 시 설정 재적재 요청
+std::atomic<bool> reload_requested{false};
+
+void handle_sighup(int) {
+    reload_requested = true;
+}
+
+// SIGUSR1 수신 시 샘플링된 추적 구간 저장
+std::atomic<bool> trace_dump_requested{false};
+
+void handle_sigusr1(int) {
+    trace_dump_requested = true;
+}
+
+// SIGINT / SIGTERM 수신 시 정상 종료
+std::atomic<bool> stop_requested{false};
+
+void handle_stop(int) {
+    stop_requested = true;
+}
+
+std::filesystem::file_time_type config_mtime(const std::string& path) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    return ec ? std::filesystem::file_time_type{} : mtime;
+}
+}
 
 int main(int argc, char* argv[]) {
     // MongoDB 인스턴스 초기화 (프로그램 시작 시 한 번만)
     mongocxx::instance instance{};
     
-    // 설정 로드
-    Config config;
+    // 설정 로드 (잘못된 값이면 메시지를 출력하고 종료)
+    std::unique_ptr<Config> loaded_config;
+    try {
+        loaded_config = std::make_unique<Config>();
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid configuration: " << e.what() << std::endl;
+        return 1;
+    }
+    Config& config = *loaded_config;
     
     std::cout << "Connecting to MQTT broker at " << config.mqtt_server_address() << "..." << std::endl;
     mqtt::async_client client(config.mqtt_server_address(), config.mqtt_client_id());
@@ -24,9 +67,33 @@ int main(int argc, char* argv[]) {
 
     // 데이터베이스 매니저 생성
     DatabaseManager db_manager(config);
+    db_manager.load_device_states(mongo_client);
+
+    // 존재하는 시간 파티션 목록 (LOG_PARTITION=day / month 인 경우)
+    db_manager.log_partitions().refresh(mongo_client[config.mongo_db_name()].list_collection_names());
+
+    // 메모리 상태 스냅샷 복원 후 주기 저장 (SNAPSHOT_PATH 설정 시)
+    {
+        CollectionHandles startup_handles(mongo_client, config);
+        db_manager.snapshot_store().load(startup_handles);
+    }
+    db_manager.snapshot_store().start();
+
+    // 로그 비동기 배치 기록 (LOG_WRITER_ASYNC=true 인 경우)
+    db_manager.writer().start();
+
+    // 디바이스 최신 상태 주기 저장 (DEVICE_STATE_PERSIST=true 인 경우)
+    db_manager.state_persistence().start();
+
+    // 보존 기간 정리 (RETENTION_ENABLED=true 인 경우)
+    RetentionManager retention(config, db_manager.archive(), db_manager.log_partitions(), db_manager.cache());
+    retention.start();
+    
+    // 조회/통계 요청 처리 워커 (연결 풀 사용)
+    RequestWorkerPool request_workers(config);
     
     // MQTT 핸들러 생성 및 설정
-    MqttHandler mqtt_handler(mongo_client, &client, config, db_manager);
+    MqttHandler mqtt_handler(mongo_client, &client, config, db_manager, request_workers);
     client.set_callback(mqtt_handler);
 
     auto connOpts = mqtt::connect_options_builder()
@@ -42,10 +109,54 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // 프로그램이 종료되지 않도록 대기
-    while (true) {
+    // 설정 재적재: SIGHUP 또는 설정 파일 변경 감지 시 Tunables 교체
+    std::signal(SIGHUP, handle_sighup);
+    std::signal(SIGUSR1, handle_sigusr1);
+    std::signal(SIGINT, handle_stop);
+    std::signal(SIGTERM, handle_stop);
+    auto loaded_mtime = config_mtime(config.file());
+
+    // 종료 신호가 올 때까지 대기
+    while (!stop_requested) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        auto mtime = config_mtime(config.file());
+        if (reload_requested.exchange(false) || mtime != loaded_mtime) {
+            loaded_mtime = mtime;
+            config.reload();
+        }
+        if (trace_dump_requested.exchange(false)) {
+            db_manager.tracing().dump();
+        }
+    }
+
+    // 정상 종료: 수신 중단 → 요청 큐 처리 → 집계 구간/상태 저장 → 기록 큐 비우기 → 연결 종료 (SHUTDOWN_TIMEOUT_MS 내)
+    std::cout << "Shutting down (timeout " << config.shutdown_timeout_ms() << " ms)..." << std::endl;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.shutdown_timeout_ms());
+
+    mqtt_handler.stop_intake();
+    auto drained = request_workers.drain(deadline);
+    auto pending = mqtt_handler.flush_pending();
+    auto written = db_manager.writer().drain(deadline);
+    db_manager.state_persistence().stop();
+    retention.stop();
+    db_manager.snapshot_store().stop();
+    db_manager.snapshot_store().save();
+    if (db_manager.tracing().enabled()) {
+        db_manager.tracing().dump();
+    }
+
+    auto remaining = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count());
+    try {
+        client.disconnect(static_cast<int>(remaining))->wait_for(std::chrono::milliseconds(remaining));
+    } catch (const mqtt::exception& exc) {
+        std::cerr << "Error disconnecting from MQTT broker: " << exc.what() << std::endl;
     }
 
+    std::cout << "Shutdown complete: " << drained.completed << " requests, " << pending.flushed
+              << " pending logs and " << written.flushed << " queued writes flushed, " << drained.abandoned
+              << " requests, " << pending.abandoned << " pending logs, " << written.abandoned
+              << " queued writes and " << mqtt_handler.rejected_count() << " late messages abandoned" << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "mqtt_handler.h"
+#include "topic_router.h"
+#include "telemetry_record.h"
+#include "ulid.h"
 #include <iostream>
-#include <regex>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -8,8 +10,10 @@ using json = nlohmann::json;
 MqttHandler::MqttHandler(mongocxx::client& client, 
                         mqtt::async_client* mqtt_client, 
                         const Config& cfg,
-                        DatabaseManager& db_mgr) 
-    : mongo_client(client), mqtt_client(mqtt_client), config(cfg), db_manager(db_mgr) {
+                        DatabaseManager& db_mgr,
+                        RequestWorkerPool& workers) 
+    : mongo_client(client), mqtt_client(mqtt_client), config(cfg), db_manager(db_mgr), request_workers(workers),
+      handles(client, cfg) {
     load_device_states();
 }
 
@@ -31,6 +35,12 @@ void MqttHandler::connection_lost(const std::string& cause) {
 }
 
 void MqttHandler::message_arrived(mqtt::const_message_ptr msg) {
+    std::lock_guard<std::mutex> intake(intake_mutex);
+    if (!accepting) {
+        ++rejected;
+        return;
+    }
+
     try {
         std::string topic_str = msg->get_topic();
         
@@ -38,7 +48,11 @@ void MqttHandler::message_arrived(mqtt::const_message_ptr msg) {
         if (topic_str == config.query_request_topic()) {
             json query = json::parse(msg->get_payload_str());
             std::cout << "Processing query request: " << query.value("query_id", "unknown") << std::endl;
-            db_manager.process_query_request(mongo_client, mqtt_client, query);
+            if (!request_workers.submit([this, query](CollectionHandles& worker_handles) {
+                    db_manager.process_query_request(worker_handles, mqtt_client, query);
+                })) {
+                std::cerr << "Request queue full. Dropping query: " << query.value("query_id", "unknown") << std::endl;
+            }
             return;
         }
 
@@ -46,37 +60,68 @@ void MqttHandler::message_arrived(mqtt::const_message_ptr msg) {
         if (topic_str == config.statistics_request_topic()) {
             json request = json::parse(msg->get_payload_str());
             
-            // 요청 ID가 없으면 생성
+            // 요청 ID가 없으면 생성 (중복 요청 판별에 쓰이므로 같은 밀리초의 요청끼리도 겹치지 않게 ULID 사용)
             if (!request.contains("request_id")) {
-                auto now = std::chrono::system_clock::now();
-                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-                request["request_id"] = std::to_string(ms);
+                request["request_id"] = generate_ulid();
             }
             
             std::cout << "Processing statistics request for: " << request.value("device_id", "unknown") 
                       << " (ID: " << request["request_id"] << ")" << std::endl;
             
-            db_manager.process_statistics_request(mongo_client, mqtt_client, request);
+            if (!request_workers.submit([this, request](CollectionHandles& worker_handles) {
+                    db_manager.process_statistics_request(worker_handles, mqtt_client, request);
+                })) {
+                std::cerr << "Request queue full. Dropping statistics request: " << request["request_id"] << std::endl;
+            }
             return;
         }
 
+        // 디바이스 메시지 처리 단계 추적 (샘플링된 경우만)
+        Tracer::Trace trace(db_manager.tracing(), "ingest");
+
         // 토픽 파싱 (factory/{device_id}/...)
-        std::regex topic_regex("factory/([^/]+)/");
-        std::smatch matches;
-        if (!std::regex_search(topic_str, matches, topic_regex) || matches.size() != 2) {
+        DeviceTopic route;
+        if (!DeviceTopic::parse(topic_str, route)) {
+            return;
+        }
+        // 이 서비스가 발행한 알람 (factory/# 구독으로 되돌아온 메시지)
+        if (route.channel == "alarm") {
+            return;
+        }
+        const std::string& device_id = route.device_id;
+
+        // 배치 전송은 별도 처리 (페이로드가 JSON 배열)
+        if (route.is_batch()) {
+            handle_batch(route, topic_str, msg->get_payload_str());
             return;
         }
-        std::string device_id = matches[1].str();
 
         // 페이로드 파싱
-        json payload = json::parse(msg->get_payload_str());
-        std::string log_code = payload.value("log_code", "");
+        // 바이너리 로그(.../cbor, .../msgpack)는 DOM 없이 고정 필드만 디코딩하고,
+        // 통계(INF)처럼 구조화된 페이로드만 전체 문서로 다시 읽어 JSON과 같은 경로로 처리
+        json payload;
+        TelemetryRecord record;
+        bool binary = route.format != PayloadFormat::JSON;
+        Tracer::Span parse_span(Tracer::PARSE);
+        if (binary) {
+            if (!TelemetryRecord::decode(msg->get_payload_str(), route.format, record)) {
+                std::cerr << "Binary payload decode error on topic: " << topic_str << std::endl;
+                return;
+            }
+            if (record.structured) {
+                payload = TelemetryRecord::decode_document(msg->get_payload_str(), route.format);
+                binary = false;
+            }
+        } else {
+            payload = json::parse(msg->get_payload_str());
+        }
+        parse_span.end();
+        std::string log_code = binary ? record.log_code : payload.value("log_code", "");
 
         // INF 로그 코드 처리 (통계 데이터)
-        if (log_code == "INF" && payload.contains("message") && payload.contains("time_range")) {
+        if (!binary && log_code == "INF" && payload.contains("message") && payload.contains("time_range")) {
             // 통계 데이터를 별도 컬렉션에 저장
-            auto db = mongo_client[config.mongo_db_name()];
-            db_manager.save_statistics_to_mongodb(db, device_id, payload);
+            db_manager.save_statistics_to_mongodb(handles, device_id, payload);
             
             // 일반 로그로도 저장할지 결정 (선택사항)
             // 현재는 통계 전용으로만 저장
@@ -85,7 +130,7 @@ void MqttHandler::message_arrived(mqtt::const_message_ptr msg) {
 
         // SHD/STR 처리 (shutdown 상태 확인보다 먼저)
         if (log_code == "SHD") {
-            std::string msg_device_id = payload.value("message", "");
+            std::string msg_device_id = binary ? record.message : payload.value("message", "");
             if (msg_device_id == device_id) {
                 set_device_shutdown(device_id);
             }
@@ -102,34 +147,42 @@ void MqttHandler::message_arrived(mqtt::const_message_ptr msg) {
             return; // 조용히 무시
         }
 
-        // 로그 토픽 파싱 (factory/{device_id}/log/{log_level})
-        std::regex log_topic_regex("factory/([^/]+)/log/([^/]+)");
-        std::smatch log_matches;
-        if (!std::regex_match(topic_str, log_matches, log_topic_regex) || log_matches.size() != 3) {
+        // 로그 토픽 확인 (factory/{device_id}/log/{log_level}[/{cbor|msgpack}])
+        if (!route.is_log()) {
             return;
         }
-        std::string log_level = log_matches[2].str();
+        const std::string& log_level = route.level;
 
         // request 토픽 처리 (통계 데이터 요청)
         if (log_level == "request") {
             std::string response_topic = "factory/" + device_id + "/log/response";
-            db_manager.process_statistics_data_request(mongo_client, mqtt_client, device_id, response_topic);
+            if (!request_workers.submit([this, device_id, response_topic](CollectionHandles& worker_handles) {
+                    db_manager.process_statistics_data_request(worker_handles, mqtt_client, device_id, response_topic);
+                })) {
+                std::cerr << "Request queue full. Dropping statistics data request: " << device_id << std::endl;
+            }
             return;
         }
 
         std::cout << "Message arrived on topic: " << topic_str << std::endl;
 
-        // MongoDB에서 디바이스 정보 조회
-        auto db = mongo_client[config.mongo_db_name()];
-        auto device_info_opt = db_manager.get_device_info(db, device_id);
-        if (!device_info_opt) {
+        // 디바이스 정보 조회 (캐시 적재 시 계산된 컨텍스트)
+        DeviceCache::DevicePtr device;
+        {
+            Tracer::Span span(Tracer::DEVICE_LOOKUP);
+            device = db_manager.get_device_info(handles, device_id);
+        }
+        if (!device) {
             std::cerr << "Device '" << device_id << "' not found in DB. Skipping." << std::endl;
             return;
         }
-        auto device_info = device_info_opt->view();
 
         // 로그 저장
-        db_manager.save_log_to_mongodb(db, device_id, log_level, payload, topic_str, device_info);
+        if (binary) {
+            db_manager.save_log_to_mongodb(handles, device_id, log_level, record, topic_str, *device, mqtt_client);
+        } else {
+            db_manager.save_log_to_mongodb(handles, device_id, log_level, payload, topic_str, *device, mqtt_client);
+        }
 
     } catch (const json::parse_error& e) {
         std::cerr << "JSON parse error: " << e.what() << " on topic: " << msg->get_topic() << std::endl;
@@ -138,12 +191,105 @@ void MqttHandler::message_arrived(mqtt::const_message_ptr msg) {
     }
 }
 
+void MqttHandler::stop_intake() {
+    accepting = false;
+    if (mqtt_client && mqtt_client->is_connected()) {
+        try {
+            mqtt_client->unsubscribe(config.mqtt_topic());
+            mqtt_client->unsubscribe(config.query_request_topic());
+            mqtt_client->unsubscribe(config.statistics_request_topic());
+        } catch (const std::exception& e) {
+            std::cerr << "Error unsubscribing: " << e.what() << std::endl;
+        }
+    }
+
+    // 처리 중이던 콜백이 끝날 때까지 대기
+    std::lock_guard<std::mutex> intake(intake_mutex);
+    std::cout << "Message intake stopped" << std::endl;
+}
+
+DatabaseManager::FlushResult MqttHandler::flush_pending() {
+    std::lock_guard<std::mutex> intake(intake_mutex);
+    save_device_states();
+    return db_manager.flush_pending(handles, mqtt_client);
+}
+
+void MqttHandler::handle_batch(const DeviceTopic& route, const std::string& topic, const std::string& payload) {
+    const std::string& device_id = route.device_id;
+
+    // [{...}, {...}] 또는 {"readings": [...]}
+    Tracer::Span parse_span(Tracer::PARSE);
+    json readings = json::parse(payload);
+    if (readings.is_object() && readings.contains("readings")) {
+        readings = readings["readings"];
+    }
+    if (!readings.is_array()) {
+        std::cerr << "Batch payload must be an array on topic: " << topic << std::endl;
+        return;
+    }
+
+    std::vector<json> statistics;
+    std::vector<TelemetryRecord> records;
+    records.reserve(readings.size());
+    size_t skipped = 0;
+
+    for (const auto& item : readings) {
+        if (!item.is_object()) {
+            ++skipped;
+            continue;
+        }
+        std::string log_code = item.value("log_code", "");
+
+        // INF 통계 데이터
+        if (log_code == "INF" && item.contains("message") && item.contains("time_range")) {
+            statistics.push_back(item);
+            continue;
+        }
+        // SHD/STR 같은 상태 제어는 개별 메시지로만 처리
+        if (log_code == "SHD" || log_code == "STR") {
+            ++skipped;
+            continue;
+        }
+        try {
+            records.push_back(TelemetryRecord::from_json(item));
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid batch reading for " << device_id << ": " << e.what() << std::endl;
+            ++skipped;
+        }
+    }
+    parse_span.end();
+
+    std::cout << "Batch arrived on topic: " << topic << " (" << records.size() << " logs, "
+              << statistics.size() << " statistics, " << skipped << " skipped)" << std::endl;
+
+    if (!statistics.empty()) {
+        db_manager.save_statistics_batch(handles, device_id, statistics);
+    }
+
+    if (records.empty() || is_device_shutdown(device_id)) {
+        return;
+    }
+
+    // 디바이스 조회는 배치당 한 번
+    DeviceCache::DevicePtr device;
+    {
+        Tracer::Span span(Tracer::DEVICE_LOOKUP);
+        device = db_manager.get_device_info(handles, device_id);
+    }
+    if (!device) {
+        std::cerr << "Device '" << device_id << "' not found in DB. Skipping batch." << std::endl;
+        return;
+    }
+    db_manager.save_log_batch(handles, device_id, route.level, records, topic, *device, mqtt_client);
+}
+
 void MqttHandler::load_device_states() {
     std::ifstream file(state_file);
     std::string device_id;
     while (std::getline(file, device_id)) {
         if (!device_id.empty()) {
             shutdown_devices.insert(device_id);
+            db_manager.device_state_table().set_shutdown(device_id, true);
         }
     }
     std::cout << "Loaded " << shutdown_devices.size() << " shutdown devices" << std::endl;
@@ -159,6 +305,7 @@ void MqttHandler::save_device_states() {
 void MqttHandler::set_device_shutdown(const std::string& device_id) {
     if (shutdown_devices.insert(device_id).second) {
         save_device_states();
+        db_manager.device_state_table().set_shutdown(device_id, true);
         std::cout << "Device " << device_id << " marked as shutdown" << std::endl;
     }
 }
@@ -166,6 +313,7 @@ void MqttHandler::set_device_shutdown(const std::string& device_id) {
 void MqttHandler::set_device_active(const std::string& device_id) {
     if (shutdown_devices.erase(device_id)) {
         save_device_states();
+        db_manager.device_state_table().set_shutdown(device_id, false);
         std::cout << "Device " << device_id << " started" << std::endl;
     }
 }
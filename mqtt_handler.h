@@ -3,10 +3,15 @@
 #include <mongocxx/client.hpp>
 #include <unordered_set>
 #include <memory>
+#include <mutex>
+#include <atomic>
 #include <string>
 #include <fstream>
 #include "config.h"
 #include "database_manager.h"
+#include "request_worker_pool.h"
+#include "topic_router.h"
+#include "collection_handles.h"
 
 class MqttHandler : public virtual mqtt::callback {
 private:
@@ -14,6 +19,13 @@ private:
     mqtt::async_client* mqtt_client;
     const Config& config;
     DatabaseManager& db_manager;
+    RequestWorkerPool& request_workers;
+    CollectionHandles handles;   // MQTT 콜백 스레드 전용
+
+    // 종료 시 수신 중단 (처리 중인 메시지는 intake_mutex로 끝날 때까지 대기)
+    std::mutex intake_mutex;
+    std::atomic<bool> accepting{true};
+    std::atomic<size_t> rejected{0};
     
     // 디바이스 상태 관리
     std::unordered_set<std::string> shutdown_devices;
@@ -25,13 +37,26 @@ private:
     void set_device_active(const std::string& device_id);
     bool is_device_shutdown(const std::string& device_id) const;
 
+    // factory/{device_id}/log/{level}/batch 처리
+    void handle_batch(const DeviceTopic& route, const std::string& topic, const std::string& payload);
+
 public:
     MqttHandler(mongocxx::client& client, 
                 mqtt::async_client* mqtt_client, 
                 const Config& cfg,
-                DatabaseManager& db_mgr);
+                DatabaseManager& db_mgr,
+                RequestWorkerPool& workers);
 
     void connected(const std::string& cause) override;
     void connection_lost(const std::string& cause) override;
     void message_arrived(mqtt::const_message_ptr msg) override;
+
+    // 구독 해제 후 이후 도착하는 메시지는 버림 (반환 시점에 처리 중인 메시지 없음)
+    void stop_intake();
+
+    // 저장 정책에 남은 집계 구간과 디바이스 상태 저장 (stop_intake 이후 호출)
+    DatabaseManager::FlushResult flush_pending();
+
+    // 수신 중단 이후 버린 메시지 수
+    size_t rejected_count() const { return rejected.load(); }
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "query_cache.h"
+#include <vector>
+#include <algorithm>
+
+QueryCache::QueryCache(const Config& cfg)
+    : max_bytes(cfg.query_cache_max_bytes()) {}
+
+size_t QueryCache::entry_size(const Entry& entry) {
+    return entry.key.size() + entry.payload.size() +
+           entry.tags.device_id.size() + entry.tags.log_code.size();
+}
+
+void QueryCache::erase_locked(std::list<Entry>::iterator it) {
+    if (it->tags.device_id.empty()) {
+        any_device.erase(it->key);
+    } else {
+        auto dev_it = by_device.find(it->tags.device_id);
+        if (dev_it != by_device.end()) {
+            dev_it->second.erase(it->key);
+            if (dev_it->second.empty()) by_device.erase(dev_it);
+        }
+    }
+    bytes -= entry_size(*it);
+    index.erase(it->key);
+    lru.erase(it);
+}
+
+uint64_t QueryCache::generation_locked(const Tags& tags) const {
+    // device_id가 없는 항목은 모든 디바이스의 로그와 매칭되므로 어떤 무효화든 영향을 받음
+    if (tags.device_id.empty()) return sequence;
+    auto it = device_generations.find(tags.device_id);
+    return std::max(cleared_at, it != device_generations.end() ? it->second : 0);
+}
+
+uint64_t QueryCache::generation(const Tags& tags) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return generation_locked(tags);
+}
+
+bool QueryCache::get(const std::string& key, std::string& payload) {
+    if (!enabled()) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++misses;
+        return false;
+    }
+    lru.splice(lru.begin(), lru, it->second);
+    payload = it->second->payload;
+    ++hits;
+    return true;
+}
+
+void QueryCache::put(const std::string& key, std::string payload, const Tags& tags, uint64_t generation) {
+    if (!enabled()) return;
+
+    Entry entry{key, std::move(payload), tags};
+    size_t size = entry_size(entry);
+    if (size > max_bytes) return;  // 단일 항목이 전체 용량보다 크면 캐시하지 않음
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (generation_locked(tags) != generation) {
+        ++stale_puts;
+        return;
+    }
+    auto existing = index.find(key);
+    if (existing != index.end()) {
+        erase_locked(existing->second);
+    }
+
+    while (!lru.empty() && bytes + size > max_bytes) {
+        erase_locked(std::prev(lru.end()));
+        ++evictions;
+    }
+
+    lru.push_front(std::move(entry));
+    index[key] = lru.begin();
+    if (tags.device_id.empty()) {
+        any_device.insert(key);
+    } else {
+        by_device[tags.device_id].insert(key);
+    }
+    bytes += size;
+}
+
+void QueryCache::invalidate(const std::string& device_id, const std::string& log_code) {
+    if (!enabled()) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // 항목이 없어도 세대는 올림 (진행 중인 조회 결과가 저장되지 않도록)
+    device_generations[device_id] = ++sequence;
+    if (index.empty()) return;
+
+    std::vector<std::list<Entry>::iterator> stale;
+    auto collect = [&](const std::unordered_set<std::string>& keys) {
+        for (const auto& key : keys) {
+            auto it = index.find(key);
+            if (it == index.end()) continue;
+            const Tags& tags = it->second->tags;
+            if (tags.log_code.empty() || tags.log_code == log_code) {
+                stale.push_back(it->second);
+            }
+        }
+    };
+
+    auto dev_it = by_device.find(device_id);
+    if (dev_it != by_device.end()) collect(dev_it->second);
+    collect(any_device);
+
+    for (auto it : stale) {
+        erase_locked(it);
+    }
+    invalidations += stale.size();
+}
+
+void QueryCache::clear() {
+    if (!enabled()) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    cleared_at = ++sequence;
+    invalidations += index.size();
+    lru.clear();
+    index.clear();
+    by_device.clear();
+    any_device.clear();
+    bytes = 0;
+}
+
+json QueryCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t lookups = hits + misses;
+
+    json result;
+    result["entries"] = index.size();
+    result["bytes"] = bytes;
+    result["max_bytes"] = max_bytes;
+    result["hits"] = hits;
+    result["misses"] = misses;
+    result["hit_rate"] = lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+    result["evictions"] = evictions;
+    result["invalidations"] = invalidations;
+    result["stale_puts"] = stale_puts;
+    return result;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <list>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
+#include "config.h"
+
+using json = nlohmann::json;
+
+// 조회 응답 캐시 (LRU, 바이트 크기 제한)
+// 항목마다 device_id/log_code 태그를 두고, 수집 경로에서 해당 태그의 로그가 저장되면 무효화한다.
+class QueryCache {
+public:
+    // 빈 값은 모든 device_id / log_code 와 매칭 (와일드카드)
+    struct Tags {
+        std::string device_id;
+        std::string log_code;
+    };
+
+private:
+    struct Entry {
+        std::string key;
+        std::string payload;
+        Tags tags;
+    };
+
+    size_t max_bytes;
+
+    mutable std::mutex mutex;
+    std::list<Entry> lru;  // 앞쪽이 최근 사용
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::unordered_map<std::string, std::unordered_set<std::string>> by_device;
+    std::unordered_set<std::string> any_device;
+    size_t bytes = 0;
+
+    // 무효화 세대 (조회 중 무효화된 결과를 저장하지 않기 위해 사용)
+    uint64_t sequence = 0;                                         // 무효화 / clear마다 증가
+    uint64_t cleared_at = 0;                                       // 마지막 clear의 sequence
+    std::unordered_map<std::string, uint64_t> device_generations;  // device_id -> 마지막 무효화 sequence
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t invalidations = 0;
+    uint64_t stale_puts = 0;
+
+    static size_t entry_size(const Entry& entry);
+    void erase_locked(std::list<Entry>::iterator it);
+    uint64_t generation_locked(const Tags& tags) const;
+
+public:
+    QueryCache(const Config& cfg);
+
+    bool enabled() const { return max_bytes > 0; }
+
+    // 캐시 조회 (hit 시 payload 복사)
+    bool get(const std::string& key, std::string& payload);
+
+    // 조회 시작 전 태그의 세대 (put에 그대로 전달)
+    uint64_t generation(const Tags& tags) const;
+
+    // 캐시 저장 (용량 초과 시 오래된 항목부터 제거)
+    // generation 이후 같은 태그가 무효화됐으면 조회 결과가 이미 오래된 것이므로 저장하지 않음
+    void put(const std::string& key, std::string payload, const Tags& tags, uint64_t generation);
+
+    // 저장된 로그와 매칭될 수 있는 항목 무효화
+    void invalidate(const std::string& device_id, const std::string& log_code);
+
+    // 전체 무효화 (보존 기간 정리 등 여러 디바이스의 로그가 삭제된 경우)
+    void clear();
+
+    json stats() const;
+};
@@ -0,0 +1,74 @@
+#include "request_deduplicator.h"
+
+RequestDeduplicator::RequestDeduplicator(const Config& cfg)
+    : config(cfg),
+      last_sweep(clock::now()) {}
+
+void RequestDeduplicator::sweep_locked(clock::time_point now, int64_t window_ms) {
+    // 창 길이마다 한 번 만료 ID 정리
+    if (now - last_sweep < std::chrono::milliseconds(window_ms)) return;
+    last_sweep = now;
+
+    for (auto it = recent.begin(); it != recent.end();) {
+        it = now - it->second >= std::chrono::milliseconds(window_ms) ? recent.erase(it) : std::next(it);
+    }
+}
+
+bool RequestDeduplicator::seen(const std::string& id) {
+    int64_t window_ms = config.request_dedup_window_ms();
+    if (id.empty() || window_ms <= 0) return false;
+
+    auto now = clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    sweep_locked(now, window_ms);
+
+    auto it = recent.find(id);
+    if (it != recent.end() && now - it->second < std::chrono::milliseconds(window_ms)) {
+        ++duplicates;
+        return true;
+    }
+    recent[id] = now;
+    return false;
+}
+
+RequestDeduplicator::Ticket RequestDeduplicator::join(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Ticket ticket;
+
+    auto it = in_flight.find(key);
+    if (it != in_flight.end()) {
+        ++coalesced;
+        ticket.result = it->second->result;
+        return ticket;
+    }
+
+    auto entry = std::make_unique<InFlight>();
+    entry->result = entry->promise.get_future().share();
+    ticket.leader = true;
+    ticket.result = entry->result;
+    in_flight.emplace(key, std::move(entry));
+    return ticket;
+}
+
+void RequestDeduplicator::complete(const std::string& key, const std::string& result) {
+    std::unique_ptr<InFlight> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = in_flight.find(key);
+        if (it == in_flight.end()) return;
+        entry = std::move(it->second);
+        in_flight.erase(it);
+    }
+    entry->promise.set_value(result);
+}
+
+json RequestDeduplicator::stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    json result;
+    result["window_ms"] = config.request_dedup_window_ms();
+    result["recent_ids"] = recent.size();
+    result["in_flight"] = in_flight.size();
+    result["duplicates"] = duplicates;
+    result["coalesced"] = coalesced;
+    return result;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "config.h"
+
+using json = nlohmann::json;
+
+// 요청 중복 제거 및 처리 중 요청 병합
+// - seen(): 같은 ID(query_id / request_id)가 시간 창 안에 다시 오면 중복 (QoS 1 재전송)
+// - join(): 같은 내용의 요청이 처리 중이면 새로 계산하지 않고 그 결과를 함께 받음
+class RequestDeduplicator {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Ticket {
+        bool leader = false;                  // true면 직접 계산 후 complete() 호출
+        std::shared_future<std::string> result;
+    };
+
+    // 리더의 결과 전달 (예외로 빠져나가도 소멸자에서 빈 결과로 완료 처리)
+    class Completion {
+    private:
+        RequestDeduplicator* owner;
+        std::string key;
+        std::string result;
+
+    public:
+        Completion(RequestDeduplicator& dedup, const Ticket& ticket, std::string request_key)
+            : owner(ticket.leader ? &dedup : nullptr), key(std::move(request_key)) {}
+        ~Completion() { if (owner) owner->complete(key, result); }
+        Completion(const Completion&) = delete;
+        Completion& operator=(const Completion&) = delete;
+
+        void set(std::string value) { result = std::move(value); }
+    };
+
+private:
+    const Config& config;
+
+    std::mutex mutex;
+    struct InFlight {
+        std::promise<std::string> promise;
+        std::shared_future<std::string> result;
+    };
+
+    std::unordered_map<std::string, clock::time_point> recent;   // ID -> 처음 수신 시각
+    std::unordered_map<std::string, std::unique_ptr<InFlight>> in_flight;
+    clock::time_point last_sweep;
+    uint64_t duplicates = 0;
+    uint64_t coalesced = 0;
+
+    void sweep_locked(clock::time_point now, int64_t window_ms);
+
+public:
+    RequestDeduplicator(const Config& cfg);
+
+    // 시간 창 안에 이미 받은 ID면 true (처음이면 기록 후 false)
+    bool seen(const std::string& id);
+
+    Ticket join(const std::string& key);
+    void complete(const std::string& key, const std::string& result);
+
+    json stats();
+};
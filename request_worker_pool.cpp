@@ -0,0 +1,92 @@
+#include "request_worker_pool.h"
+#include <iostream>
+#include <mongocxx/uri.hpp>
+
+RequestWorkerPool::RequestWorkerPool(const Config& cfg)
+    : config(cfg), pool(mongocxx::uri{cfg.mongo_uri()}) {
+    int64_t count = cfg.request_workers();
+    for (int64_t i = 0; i < count; ++i) {
+        workers.emplace_back(&RequestWorkerPool::run, this);
+    }
+    std::cout << "Request workers started: " << count << std::endl;
+}
+
+RequestWorkerPool::~RequestWorkerPool() {
+    stop();
+}
+
+bool RequestWorkerPool::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running || queue.size() >= static_cast<size_t>(config.request_queue_max())) {
+            return false;
+        }
+        queue.push_back(std::move(task));
+    }
+    cv.notify_one();
+    return true;
+}
+
+void RequestWorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    cv.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+RequestWorkerPool::DrainResult RequestWorkerPool::drain(std::chrono::steady_clock::time_point deadline) {
+    DrainResult result;
+    size_t completed_before = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!running) return result;
+        running = false;
+        completed_before = completed;
+        cv.notify_all();
+
+        idle_cv.wait_until(lock, deadline, [this] { return queue.empty() && active == 0; });
+        result.abandoned = queue.size();
+        queue.clear();
+    }
+
+    // 처리 중인 요청은 끝날 때까지 기다림 (MongoDB 호출은 중간에 취소할 수 없음)
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    result.completed = completed - completed_before;
+    return result;
+}
+
+void RequestWorkerPool::run() {
+    auto client = pool.acquire();
+    CollectionHandles handles(*client, config);
+
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return !running || !queue.empty(); });
+            if (queue.empty()) return;  // 종료 요청 + 큐 비움
+            task = std::move(queue.front());
+            queue.pop_front();
+            ++active;
+        }
+
+        try {
+            task(handles);
+        } catch (const std::exception& e) {
+            std::cerr << "Request worker error: " << e.what() << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        --active;
+        ++completed;
+        if (queue.empty() && active == 0) idle_cv.notify_all();
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include <mongocxx/pool.hpp>
+#include <mongocxx/client.hpp>
+#include "config.h"
+#include "collection_handles.h"
+
+// 조회/통계 요청 처리 스레드 풀
+// MQTT 콜백 스레드는 요청을 큐에 넣기만 하고, 각 워커는 mongocxx::pool에서 받은 자기 클라이언트와
+// 그 클라이언트로 만든 컬렉션 핸들 캐시로 처리한다.
+class RequestWorkerPool {
+public:
+    using Task = std::function<void(CollectionHandles&)>;
+
+    // 종료 시 큐 처리 결과
+    struct DrainResult {
+        size_t completed = 0;
+        size_t abandoned = 0;
+    };
+
+private:
+    const Config& config;
+    mongocxx::pool pool;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable idle_cv;   // 큐가 비고 처리 중인 요청이 없을 때
+    std::deque<Task> queue;
+    size_t active = 0;
+    size_t completed = 0;
+    bool running = true;
+
+    void run();
+
+public:
+    RequestWorkerPool(const Config& cfg);
+    ~RequestWorkerPool();
+
+    // 큐가 가득 차면 false
+    bool submit(Task task);
+
+    // 남은 요청을 모두 처리한 뒤 종료
+    void stop();
+
+    // 새 요청을 받지 않고 deadline까지 남은 요청을 처리한 뒤 종료 (넘으면 남은 큐는 버림)
+    DrainResult drain(std::chrono::steady_clock::time_point deadline);
+};
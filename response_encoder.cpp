@@ -0,0 +1,153 @@
+#include "response_encoder.h"
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace {
+std::string base64(const std::string& data) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        uint32_t n = (uint8_t(data[i]) << 16) | (uint8_t(data[i + 1]) << 8) | uint8_t(data[i + 2]);
+        out += table[(n >> 18) & 63];
+        out += table[(n >> 12) & 63];
+        out += table[(n >> 6) & 63];
+        out += table[n & 63];
+    }
+    if (i < data.size()) {
+        uint32_t n = uint8_t(data[i]) << 16;
+        if (i + 1 < data.size()) n |= uint8_t(data[i + 1]) << 8;
+        out += table[(n >> 18) & 63];
+        out += table[(n >> 12) & 63];
+        out += i + 1 < data.size() ? table[(n >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+std::string deflate(const std::string& data) {
+    uLongf size = compressBound(data.size());
+    std::string out(size, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(&out[0]), &size,
+                  reinterpret_cast<const Bytef*>(data.data()), data.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+        throw std::runtime_error("deflate failed");
+    }
+    out.resize(size);
+    return out;
+}
+}
+
+std::string ResponseEncoder::Encoding::name() const {
+    std::string result;
+    if (columnar) result = "columnar";
+    if (dictionary) result += "+dict";
+    if (deflate) result += result.empty() ? "deflate" : "+deflate";
+    return result.empty() ? "json" : result;
+}
+
+ResponseEncoder::ResponseEncoder(const Config& cfg) : compress_min_bytes(cfg.response_compress_min_bytes()) {}
+
+ResponseEncoder::Encoding ResponseEncoder::parse(const json& query) {
+    Encoding encoding;
+    if (!query.contains("encoding")) return encoding;
+    if (!query["encoding"].is_string()) throw std::invalid_argument("encoding must be a string");
+
+    std::stringstream parts(query["encoding"].get<std::string>());
+    std::string part;
+    while (std::getline(parts, part, '+')) {
+        if (part.empty() || part == "json") continue;
+        if (part == "columnar") encoding.columnar = true;
+        else if (part == "dict") encoding.columnar = encoding.dictionary = true;
+        else if (part == "deflate" || part == "zstd") encoding.deflate = true;
+        else throw std::invalid_argument("Unsupported encoding: " + part);
+    }
+    return encoding;
+}
+
+void ResponseEncoder::to_columnar(json& response, bool dictionary) {
+    if (!response.contains("data") || !response["data"].is_array()) return;
+    const json& rows = response["data"];
+
+    // 열 목록은 모든 행의 키 합집합 (행마다 없는 값은 null)
+    std::map<std::string, json> columns;
+    for (const auto& row : rows) {
+        if (!row.is_object()) return;
+        for (const auto& [key, value] : row.items()) columns.emplace(key, json::array());
+    }
+    for (const auto& row : rows) {
+        for (auto& [key, values] : columns) {
+            auto it = row.find(key);
+            values.push_back(it != row.end() ? *it : json(nullptr));
+        }
+    }
+
+    json dictionary_columns = json::array();
+    json strings = json::array();
+    if (dictionary) {
+        std::unordered_map<std::string, size_t> index;
+        for (auto& [key, values] : columns) {
+            // 문자열만 있고 값이 반복되는 열만 치환 (_id처럼 모두 다른 값은 그대로)
+            std::unordered_map<std::string, size_t> distinct;
+            bool all_strings = !values.empty();
+            for (const auto& value : values) {
+                if (!value.is_string()) { all_strings = false; break; }
+                distinct.emplace(value.get_ref<const std::string&>(), 0);
+            }
+            if (!all_strings || distinct.size() == values.size()) continue;
+
+            for (auto& value : values) {
+                const auto& text = value.get_ref<const std::string&>();
+                auto [it, inserted] = index.emplace(text, strings.size());
+                if (inserted) strings.push_back(text);
+                value = it->second;
+            }
+            dictionary_columns.push_back(key);
+        }
+    }
+
+    json data = json::object();
+    for (auto& [key, values] : columns) data[key] = std::move(values);
+    response["data"] = std::move(data);
+    if (!dictionary_columns.empty()) {
+        response["dictionary"] = std::move(strings);
+        response["dictionary_columns"] = std::move(dictionary_columns);
+    }
+}
+
+std::string ResponseEncoder::encode(const Encoding& encoding, json response) {
+    if (encoding.identity()) return response.dump();
+
+    if (encoding.columnar) to_columnar(response, encoding.dictionary);
+
+    // 압축 전 본문의 encoding은 압축을 뺀 형식
+    Encoding plain = encoding;
+    plain.deflate = false;
+    response["encoding"] = plain.name();
+    std::string body = response.dump();
+    ++encoded;
+
+    // 작은 응답은 압축 비용이 더 크므로 압축 없이 전송
+    if (!encoding.deflate || body.size() < compress_min_bytes) return body;
+
+    json envelope;
+    envelope["status"] = response.value("status", "");
+    envelope["encoding"] = encoding.name();
+    envelope["raw_bytes"] = body.size();
+    envelope["payload"] = base64(deflate(body));
+    std::string payload = envelope.dump();
+    deflate_input_bytes += body.size();
+    deflate_output_bytes += payload.size();
+    return payload;
+}
+
+json ResponseEncoder::stats() const {
+    json result;
+    result["encoded"] = encoded.load();
+    result["deflate_input_bytes"] = deflate_input_bytes.load();
+    result["deflate_output_bytes"] = deflate_output_bytes.load();
+    return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "config.h"
+
+using json = nlohmann::json;
+
+// 조회 응답 인코딩 (요청의 "encoding" 필드로 선택, 없으면 기존 JSON 그대로)
+// "encoding": "columnar+dict+deflate" (순서 무관, 필요한 것만 조합)
+// - columnar: data 행 배열을 열별 배열로 변환 ({"device_id": [...], "timestamp": [...]}, 없는 값은 null)
+// - dict:     값이 반복되는 문자열 열을 공통 dictionary 인덱스로 치환 (columnar 포함)
+// - deflate:  JSON 본문을 zlib으로 압축해 base64로 payload에 담음 (zstd 요청도 deflate로 처리)
+class ResponseEncoder {
+public:
+    struct Encoding {
+        bool columnar = false;
+        bool dictionary = false;
+        bool deflate = false;
+
+        bool identity() const { return !columnar && !deflate; }
+        std::string name() const;
+    };
+
+private:
+    size_t compress_min_bytes;
+
+    std::atomic<uint64_t> encoded{0};
+    std::atomic<uint64_t> deflate_input_bytes{0};   // 압축 전 JSON 크기
+    std::atomic<uint64_t> deflate_output_bytes{0};  // 압축 후 payload 포함 응답 크기
+
+    static void to_columnar(json& response, bool dictionary);
+
+public:
+    ResponseEncoder(const Config& cfg);
+
+    // 요청의 encoding 필드 해석 (알 수 없는 값이면 invalid_argument)
+    static Encoding parse(const json& query);
+
+    // 응답 객체를 직렬화하며 인코딩 (기본 JSON이면 dump 그대로)
+    // 결과는 query_id 없이 만들어지므로 캐시에 두고 요청별로 query_id만 앞에 붙여 전송
+    std::string encode(const Encoding& encoding, json response);
+
+    json stats() const;
+};
@@ -0,0 +1,226 @@
+#include "retention_manager.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <mongocxx/client.hpp>
+#include <mongocxx/uri.hpp>
+#include <bsoncxx/builder/stream/document.hpp>
+#include <bsoncxx/builder/stream/array.hpp>
+#include <bsoncxx/types.hpp>
+
+using bson_builder = bsoncxx::builder::stream::document;
+using bsoncxx::builder::stream::finalize;
+
+namespace {
+constexpr int64_t DAY_MS = 24LL * 60 * 60 * 1000;
+constexpr size_t ARCHIVE_BATCH_SIZE = 1000;
+}
+
+RetentionManager::RetentionManager(const Config& cfg, LogArchive& log_archive, LogPartitions& log_partitions,
+                                   QueryCache& cache)
+    : config(cfg), archive(log_archive), partitions(log_partitions), query_cache(cache) {
+    load_rules();
+}
+
+void RetentionManager::load_rules() {
+    // 설정 재적재(SIGHUP)로 바뀔 수 있으므로 정리 주기마다 다시 읽음
+    default_days = config.retention_days();
+    level_days.clear();
+
+    // RETENTION_LEVEL_DAYS=debug:3,info:14 형식
+    std::stringstream ss(config.retention_level_days());
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t pos = item.find(':');
+        if (pos == std::string::npos) continue;
+        try {
+            level_days[item.substr(0, pos)] = std::stoll(item.substr(pos + 1));
+        } catch (const std::exception&) {
+            std::cerr << "Invalid RETENTION_LEVEL_DAYS entry: " << item << std::endl;
+        }
+    }
+}
+
+RetentionManager::~RetentionManager() {
+    stop();
+}
+
+void RetentionManager::start() {
+    if (!config.retention_enabled() || running.exchange(true)) return;
+    worker = std::thread(&RetentionManager::run, this);
+    std::cout << "Retention enabled: " << default_days << " days (interval "
+              << config.retention_interval_sec() << "s)" << std::endl;
+}
+
+void RetentionManager::stop() {
+    if (!running.exchange(false)) return;
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void RetentionManager::run() {
+    // mongocxx::client는 스레드 간 공유 불가 → 전용 연결 사용
+    mongocxx::client client{mongocxx::uri{config.mongo_uri()}};
+    auto db = client[config.mongo_db_name()];
+
+    while (running) {
+        try {
+            run_once(db);
+        } catch (const std::exception& e) {
+            std::cerr << "Error running retention: " << e.what() << std::endl;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait_for(lock, std::chrono::seconds(config.retention_interval_sec()), [this] { return !running; });
+    }
+}
+
+size_t RetentionManager::run_once(mongocxx::database& db) {
+    load_rules();
+
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // 파티션 전체 삭제 기준은 가장 긴 보존 기간, 건너뛰기 기준은 가장 짧은 보존 기간
+    int64_t longest_days = default_days;
+    int64_t shortest_days = default_days;
+    for (const auto& [level, days] : level_days) {
+        longest_days = std::max(longest_days, days);
+        shortest_days = std::min(shortest_days, days);
+    }
+
+    auto names = db.list_collection_names();
+    partitions.refresh(names);
+
+    size_t removed = 0;
+    for (const auto& name : names) {
+        if (name.rfind("logs_", 0) != 0) continue;
+
+        int64_t begin = 0, end = 0;
+        if (partitions.range_of(name, begin, end)) {
+            if (end <= now_ms - longest_days * DAY_MS) {
+                removed += drop_partition(db, name);
+                continue;
+            }
+            if (begin >= now_ms - shortest_days * DAY_MS) continue;  // 아직 만료된 로그 없음
+        }
+        removed += prune_collection(db, name, now_ms);
+    }
+
+    if (removed > 0) {
+        // 삭제된 로그가 캐시된 조회 결과에 남지 않도록 전체 무효화
+        query_cache.clear();
+        std::cout << "Retention removed " << removed << " expired logs" << std::endl;
+    }
+    return removed;
+}
+
+size_t RetentionManager::prune_collection(mongocxx::database& db, const std::string& name, int64_t now_ms) {
+    using bsoncxx::builder::stream::open_document;
+    using bsoncxx::builder::stream::close_document;
+
+    auto collection = db[name];
+    int64_t begin = 0, end = 0;
+    bool partition = partitions.range_of(name, begin, end);
+    bool archive_first = archive.enabled() && (partition || name == config.all_logs_collection());
+    size_t removed = 0;
+
+    // 레벨별 보존 기간이 지정된 로그
+    bsoncxx::builder::stream::array overridden;
+    for (const auto& [level, days] : level_days) {
+        overridden << level;
+        auto filter = bson_builder{}
+            << "log_level" << level
+            << "timestamp" << open_document << "$lt" << bsoncxx::types::b_int64{now_ms - days * DAY_MS} << close_document
+            << finalize;
+        removed += prune(collection, name, filter.view(), archive_first);
+    }
+
+    // 나머지 로그는 기본 보존 기간 적용
+    auto filter = bson_builder{}
+        << "log_level" << open_document << "$nin" << bsoncxx::types::b_array{overridden.view()} << close_document
+        << "timestamp" << open_document << "$lt" << bsoncxx::types::b_int64{now_ms - default_days * DAY_MS} << close_document
+        << finalize;
+    removed += prune(collection, name, filter.view(), archive_first);
+
+    return removed;
+}
+
+size_t RetentionManager::drop_partition(mongocxx::database& db, const std::string& name) {
+    auto collection = db[name];
+    auto count = static_cast<size_t>(collection.count_documents(bson_builder{} << finalize));
+
+    // 아카이브는 파티션과 관계없이 logs_all 이름으로 저장 (조회 시 같은 경로에서 스캔)
+    if (archive.enabled() && count > 0) {
+        std::vector<bsoncxx::document::value> batch;
+        mongocxx::options::find opts{};
+        opts.sort(bson_builder{} << "timestamp" << 1 << finalize);
+        for (auto&& doc : collection.find(bson_builder{} << finalize, opts)) {
+            batch.emplace_back(doc);
+            if (batch.size() >= ARCHIVE_BATCH_SIZE) {
+                if (!archive.append(config.all_logs_collection(), batch)) {
+                    std::cerr << "Archive write failed for " << name << ", skipping drop" << std::endl;
+                    return 0;
+                }
+                batch.clear();
+            }
+        }
+        if (!batch.empty() && !archive.append(config.all_logs_collection(), batch)) {
+            std::cerr << "Archive write failed for " << name << ", skipping drop" << std::endl;
+            return 0;
+        }
+    }
+
+    collection.drop();
+    partitions.forget(name);
+    std::cout << "Retention dropped partition " << name << " (" << count << " logs)" << std::endl;
+    return count;
+}
+
+size_t RetentionManager::prune(mongocxx::collection& collection, const std::string& name,
+                               const bsoncxx::document::view& filter, bool archive_first) {
+    if (!archive_first) {
+        auto result = collection.delete_many(filter);
+        return result ? static_cast<size_t>(result->deleted_count()) : 0;
+    }
+
+    // 아카이브 기록이 끝난 문서만 _id로 삭제 (정리 중 들어온 로그는 다음 주기에 처리)
+    // 파티션 문서도 logs_all 이름으로 아카이브
+    int64_t begin = 0, end = 0;
+    const std::string& archive_name = partitions.range_of(name, begin, end) ? config.all_logs_collection() : name;
+    size_t removed = 0;
+    std::vector<bsoncxx::document::value> batch;
+
+    auto flush = [&]() {
+        if (batch.empty()) return true;
+        if (!archive.append(archive_name, batch)) return false;
+
+        bsoncxx::builder::stream::array ids;
+        for (const auto& doc : batch) {
+            auto id = doc.view()["_id"];
+            if (id && id.type() == bsoncxx::type::k_string) ids << id.get_string().value;
+        }
+        auto result = collection.delete_many(bson_builder{}
+            << "_id" << bsoncxx::builder::stream::open_document << "$in" << bsoncxx::types::b_array{ids.view()}
+            << bsoncxx::builder::stream::close_document << finalize);
+        if (result) removed += static_cast<size_t>(result->deleted_count());
+        batch.clear();
+        return true;
+    };
+
+    mongocxx::options::find opts{};
+    opts.sort(bson_builder{} << "timestamp" << 1 << finalize);
+    for (auto&& doc : collection.find(filter, opts)) {
+        batch.emplace_back(doc);
+        if (batch.size() >= ARCHIVE_BATCH_SIZE && !flush()) {
+            std::cerr << "Archive write failed for " << name << ", skipping deletion" << std::endl;
+            return removed;
+        }
+    }
+    if (!flush()) {
+        std::cerr << "Archive write failed for " << name << ", skipping deletion" << std::endl;
+    }
+    return removed;
+}
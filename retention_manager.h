@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <unordered_map>
+#include <mongocxx/database.hpp>
+#include <mongocxx/collection.hpp>
+#include "config.h"
+#include "log_archive.h"
+#include "log_partitions.h"
+#include "query_cache.h"
+
+// 로그 보존 기간 관리 (주기적 정리 스레드)
+// logs_all은 삭제 전에 아카이브로 옮기고, 그룹 컬렉션(logs_*)은 사본이므로 바로 삭제한다.
+// 시간 파티션(logs_all_YYYY_MM..)은 구간 전체가 가장 긴 보존 기간보다 오래되면 아카이브 후 컬렉션째 삭제한다.
+class RetentionManager {
+private:
+    const Config& config;
+    LogArchive& archive;
+    LogPartitions& partitions;
+    QueryCache& query_cache;
+
+    int64_t default_days = 0;
+    std::unordered_map<std::string, int64_t> level_days;  // log_level -> 보존 일수
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<bool> running{false};
+
+    void load_rules();
+    void run();
+    size_t prune_collection(mongocxx::database& db, const std::string& name, int64_t now_ms);
+    size_t drop_partition(mongocxx::database& db, const std::string& name);
+    size_t prune(mongocxx::collection& collection, const std::string& name,
+                 const bsoncxx::document::view& filter, bool archive_first);
+
+public:
+    RetentionManager(const Config& cfg, LogArchive& log_archive, LogPartitions& log_partitions, QueryCache& cache);
+    ~RetentionManager();
+
+    void start();
+    void stop();
+
+    // 한 번 정리 실행 (삭제된 문서 수)
+    size_t run_once(mongocxx::database& db);
+};
@@ -0,0 +1,337 @@
+#include "sketches.h"
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "string_util.h"
+
+namespace {
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+}
+
+DDSketch::DDSketch(double relative_accuracy)
+    : gamma((1.0 + relative_accuracy) / (1.0 - relative_accuracy)),
+      log_gamma(std::log(gamma)) {}
+
+int32_t DDSketch::index_of(double magnitude) const {
+    return static_cast<int32_t>(std::ceil(std::log(magnitude) / log_gamma));
+}
+
+double DDSketch::value_of(int32_t index) const {
+    // 버킷 (gamma^(i-1), gamma^i] 의 대표값
+    return 2.0 * std::pow(gamma, index) / (gamma + 1.0);
+}
+
+void DDSketch::Store::add(int32_t index, uint64_t count) {
+    if (bins.empty()) {
+        min_index = index;
+        bins.push_back(0);
+    } else if (index < min_index) {
+        bins.insert(bins.begin(), static_cast<size_t>(min_index - index), 0);
+        min_index = index;
+    } else if (index >= min_index + static_cast<int32_t>(bins.size())) {
+        bins.resize(static_cast<size_t>(index - min_index + 1), 0);
+    }
+    bins[static_cast<size_t>(index - min_index)] += static_cast<uint32_t>(count);
+}
+
+void DDSketch::Store::merge(const Store& other) {
+    for (size_t i = 0; i < other.bins.size(); ++i) {
+        if (other.bins[i] > 0) {
+            add(other.min_index + static_cast<int32_t>(i), other.bins[i]);
+        }
+    }
+}
+
+json DDSketch::Store::to_json() const {
+    return json{{"min_index", min_index}, {"bins", bins}};
+}
+
+void DDSketch::Store::restore(const json& value) {
+    min_index = value.at("min_index").get<int32_t>();
+    bins = value.at("bins").get<std::vector<uint32_t>>();
+}
+
+void DDSketch::add(double value) {
+    if (std::isnan(value)) return;
+
+    if (total == 0) {
+        min_value = max_value = value;
+    } else {
+        min_value = std::min(min_value, value);
+        max_value = std::max(max_value, value);
+    }
+    ++total;
+
+    if (value > 0.0) {
+        positive.add(index_of(value), 1);
+    } else if (value < 0.0) {
+        negative.add(index_of(-value), 1);
+    } else {
+        ++zero_count;
+    }
+}
+
+void DDSketch::merge(const DDSketch& other) {
+    if (other.total == 0) return;
+
+    if (total == 0) {
+        min_value = other.min_value;
+        max_value = other.max_value;
+    } else {
+        min_value = std::min(min_value, other.min_value);
+        max_value = std::max(max_value, other.max_value);
+    }
+    total += other.total;
+    zero_count += other.zero_count;
+    positive.merge(other.positive);
+    negative.merge(other.negative);
+}
+
+double DDSketch::quantile(double q) const {
+    if (total == 0) return 0.0;
+
+    double rank = std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1);
+    uint64_t cumulative = 0;
+
+    // 음수는 절대값이 큰 버킷(작은 값)부터
+    for (size_t i = negative.bins.size(); i-- > 0;) {
+        cumulative += negative.bins[i];
+        if (static_cast<double>(cumulative) > rank) {
+            return std::clamp(-value_of(negative.min_index + static_cast<int32_t>(i)), min_value, max_value);
+        }
+    }
+
+    cumulative += zero_count;
+    if (static_cast<double>(cumulative) > rank) return 0.0;
+
+    for (size_t i = 0; i < positive.bins.size(); ++i) {
+        cumulative += positive.bins[i];
+        if (static_cast<double>(cumulative) > rank) {
+            return std::clamp(value_of(positive.min_index + static_cast<int32_t>(i)), min_value, max_value);
+        }
+    }
+    return max_value;
+}
+
+json DDSketch::to_json() const {
+    json result = positive.to_json();
+    result["negative"] = negative.to_json();
+    result["zero_count"] = zero_count;
+    result["total"] = total;
+    result["min"] = min_value;
+    result["max"] = max_value;
+    return result;
+}
+
+void DDSketch::restore(const json& value) {
+    positive.restore(value);
+    // 음수 버킷이 없는 이전 스냅샷은 음수가 zero_count에 합쳐져 있음
+    negative = Store{};
+    if (value.contains("negative")) negative.restore(value.at("negative"));
+    zero_count = value.at("zero_count").get<uint64_t>();
+    total = value.at("total").get<uint64_t>();
+    min_value = value.at("min").get<double>();
+    max_value = value.at("max").get<double>();
+}
+
+uint64_t HyperLogLog::hash(const std::string& value) {
+    // FNV-1a + splitmix64 finalizer
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : value) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+void HyperLogLog::add(const std::string& value) {
+    if (registers.empty()) registers.assign(REGISTERS, 0);
+
+    uint64_t h = hash(value);
+    size_t index = static_cast<size_t>(h >> (64 - PRECISION));
+    uint64_t rest = (h << PRECISION) | (uint64_t{1} << (PRECISION - 1));
+    uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    registers[index] = std::max(registers[index], rank);
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.registers.empty()) return;
+    if (registers.empty()) {
+        registers = other.registers;
+        return;
+    }
+    for (size_t i = 0; i < REGISTERS; ++i) {
+        registers[i] = std::max(registers[i], other.registers[i]);
+    }
+}
+
+uint64_t HyperLogLog::estimate() const {
+    if (registers.empty()) return 0;
+
+    const double m = static_cast<double>(REGISTERS);
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) {
+        sum += std::ldexp(1.0, -r);
+        if (r == 0) ++zeros;
+    }
+
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+
+    // 작은 범위는 linear counting으로 보정
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * std::log(m / static_cast<double>(zeros));
+    }
+    return static_cast<uint64_t>(std::llround(estimate));
+}
+
+json HyperLogLog::to_json() const {
+    return json::binary(std::vector<std::uint8_t>(registers.begin(), registers.end()));
+}
+
+void HyperLogLog::restore(const json& value) {
+    const auto& bytes = value.get_binary();
+    if (!bytes.empty() && bytes.size() != REGISTERS) {
+        throw std::invalid_argument("HyperLogLog register count mismatch");
+    }
+    registers.assign(bytes.begin(), bytes.end());
+}
+
+void SketchStore::Summary::merge(const Summary& other) {
+    speed.merge(other.speed);
+    temperature.merge(other.temperature);
+    errors.merge(other.errors);
+}
+
+SketchStore::SketchStore(const Config& cfg)
+    : window_ms(cfg.sketch_hours() * 60 * 60 * 1000),
+      bucket_ms(std::max<int64_t>(cfg.sketch_bucket_ms(), 1000)),
+      coverage_start(now_ms()) {}
+
+bool SketchStore::covers(int64_t start_time) const {
+    if (!enabled()) return false;
+    std::lock_guard<std::mutex> lock(mutex);
+    return start_time >= coverage_start;
+}
+
+void SketchStore::evict_locked(int64_t now) {
+    // 구간 폭마다 한 번만 전체 디바이스를 정리
+    if (now - last_evict < bucket_ms) return;
+    last_evict = now;
+
+    int64_t cutoff = now - window_ms;
+    cutoff -= cutoff % bucket_ms;
+    coverage_start = std::max(coverage_start, cutoff);
+
+    for (auto it = devices.begin(); it != devices.end();) {
+        auto& buckets = it->second;
+        buckets.erase(buckets.begin(), buckets.lower_bound(cutoff));
+        it = buckets.empty() ? devices.erase(it) : std::next(it);
+    }
+}
+
+void SketchStore::record(const std::string& device_id,
+                         const std::string& log_level,
+                         const std::string& log_code,
+                         const std::string& message,
+                         const json& metadata,
+                         int64_t timestamp) {
+    if (!enabled()) return;
+
+    double speed = 0.0;
+    bool has_speed = string_util::parse_numeric(message, speed) && speed > 0.0;
+    bool has_temperature = metadata.is_object() && metadata.contains("temperature") &&
+                           metadata["temperature"].is_number();
+    bool is_error = log_level == "error";
+    if (!has_speed && !has_temperature && !is_error) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    evict_locked(now_ms());
+    if (timestamp < coverage_start) return;
+
+    Summary& bucket = devices[device_id][timestamp - timestamp % bucket_ms];
+    if (has_speed) bucket.speed.add(speed);
+    if (has_temperature) bucket.temperature.add(metadata["temperature"].get<double>());
+    if (is_error) bucket.errors.add(log_code + ":" + message);
+}
+
+SketchStore::Summary SketchStore::summarize(const std::string& device_id,
+                                            int64_t start_time, int64_t end_time) const {
+    Summary result;
+    if (!enabled()) return result;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto device = devices.find(device_id);
+    if (device == devices.end()) return result;
+
+    const auto& buckets = device->second;
+    for (auto it = buckets.lower_bound(start_time - start_time % bucket_ms);
+         it != buckets.end() && it->first <= end_time; ++it) {
+        result.merge(it->second);
+    }
+    return result;
+}
+
+json SketchStore::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    json buckets = json::array();
+    for (const auto& [device_id, device_buckets] : devices) {
+        for (const auto& [start, summary] : device_buckets) {
+            buckets.push_back({device_id, start,
+                               summary.speed.to_json(), summary.temperature.to_json(), summary.errors.to_json()});
+        }
+    }
+    return json{{"bucket_ms", bucket_ms}, {"coverage_start", coverage_start}, {"buckets", std::move(buckets)}};
+}
+
+void SketchStore::restore(const json& snapshot) {
+    if (!enabled()) return;
+    // 구간 폭이 바뀌었으면 구간 경계가 맞지 않으므로 버림
+    if (snapshot.at("bucket_ms").get<int64_t>() != bucket_ms) {
+        throw std::invalid_argument("SKETCH_BUCKET_MS changed since snapshot");
+    }
+
+    std::unordered_map<std::string, std::map<int64_t, Summary>> restored;
+    for (const auto& item : snapshot.at("buckets")) {
+        Summary& summary = restored[item.at(0).get<std::string>()][item.at(1).get<int64_t>()];
+        summary.speed.restore(item.at(2));
+        summary.temperature.restore(item.at(3));
+        summary.errors.restore(item.at(4));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    devices.swap(restored);
+    coverage_start = snapshot.at("coverage_start").get<int64_t>();
+    last_evict = 0;
+}
+
+void SketchStore::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    devices.clear();
+    coverage_start = now_ms();
+    last_evict = 0;
+}
+
+json SketchStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t buckets = 0;
+    for (const auto& [device_id, device_buckets] : devices) buckets += device_buckets.size();
+
+    json result;
+    result["enabled"] = enabled();
+    result["devices"] = devices.size();
+    result["buckets"] = buckets;
+    result["bucket_ms"] = bucket_ms;
+    result["coverage_start"] = coverage_start;
+    return result;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "config.h"
+
+using json = nlohmann::json;
+
+// 상대 오차 보장 분위수 스케치 (DDSketch)
+// 양수 v는 positive의 ceil(log_gamma(v)) 버킷, 음수는 negative의 ceil(log_gamma(-v)) 버킷에 누적되며,
+// 같은 정확도의 스케치끼리 병합할 수 있다.
+class DDSketch {
+private:
+    // 버킷 인덱스 연속 구간 [min_index, min_index + bins.size())
+    struct Store {
+        std::vector<uint32_t> bins;
+        int32_t min_index = 0;
+
+        void add(int32_t index, uint64_t count);
+        void merge(const Store& other);
+        json to_json() const;
+        void restore(const json& value);
+    };
+
+    double gamma;
+    double log_gamma;
+    Store positive;
+    Store negative;            // 절대값 기준
+    uint64_t zero_count = 0;   // 정확히 0인 값
+    uint64_t total = 0;
+    double min_value = 0.0;
+    double max_value = 0.0;
+
+    int32_t index_of(double magnitude) const;
+    double value_of(int32_t index) const;
+
+public:
+    explicit DDSketch(double relative_accuracy = 0.01);
+
+    void add(double value);
+    void merge(const DDSketch& other);
+
+    // q ∈ [0, 1], 비어 있으면 0
+    double quantile(double q) const;
+
+    uint64_t count() const { return total; }
+    bool empty() const { return total == 0; }
+
+    // 스냅샷 저장/복원 (같은 relative_accuracy로 생성한 스케치에만 복원)
+    json to_json() const;
+    void restore(const json& value);
+};
+
+// 고유값 개수 추정 (HyperLogLog, 레지스터는 첫 값 추가 시 할당)
+class HyperLogLog {
+private:
+    static constexpr int PRECISION = 11;
+    static constexpr size_t REGISTERS = size_t{1} << PRECISION;
+    std::vector<uint8_t> registers;
+
+public:
+    static uint64_t hash(const std::string& value);
+
+    void add(const std::string& value);
+    void merge(const HyperLogLog& other);
+    uint64_t estimate() const;
+    bool empty() const { return registers.empty(); }
+
+    // 스냅샷 저장/복원 (레지스터는 바이너리 그대로)
+    json to_json() const;
+    void restore(const json& value);
+};
+
+// 디바이스별 시간 구간 스케치 저장소
+// 수집 시 구간별 스케치를 갱신하고, 조회 시 범위에 걸친 구간들만 병합한다 (원시 로그 조회 없음).
+class SketchStore {
+public:
+    struct Summary {
+        DDSketch speed;          // 숫자 메시지 (> 0)
+        DDSketch temperature;    // metadata.temperature
+        HyperLogLog errors;      // error 레벨 로그의 log_code:message
+        void merge(const Summary& other);
+    };
+
+private:
+    int64_t window_ms;
+    int64_t bucket_ms;
+    int64_t coverage_start;  // 이 시각 이후 구간은 모두 집계되어 있음
+    int64_t last_evict = 0;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::map<int64_t, Summary>> devices;  // device_id -> 구간 시작 -> 스케치
+
+    void evict_locked(int64_t now);
+
+public:
+    SketchStore(const Config& cfg);
+
+    bool enabled() const { return window_ms > 0; }
+    bool covers(int64_t start_time) const;
+
+    void record(const std::string& device_id,
+                const std::string& log_level,
+                const std::string& log_code,
+                const std::string& message,
+                const json& metadata,
+                int64_t timestamp);
+
+    // 시간 범위에 걸친 구간 병합 (구간 경계 단위로 근사)
+    Summary summarize(const std::string& device_id, int64_t start_time, int64_t end_time) const;
+
+    // 스냅샷 저장/복원 (복원 후 스냅샷 이후 로그를 다시 record 해야 covers()가 정확함)
+    json snapshot() const;
+    void restore(const json& snapshot);
+    void clear();
+
+    json stats() const;
+};
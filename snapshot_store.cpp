@@ -0,0 +1,272 @@
+#include "snapshot_store.h"
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <bsoncxx/builder/stream/document.hpp>
+#include <bsoncxx/json.hpp>
+#include <bsoncxx/types.hpp>
+
+using bson_builder = bsoncxx::builder::stream::document;
+using bsoncxx::builder::stream::finalize;
+using bsoncxx::builder::stream::open_document;
+using bsoncxx::builder::stream::close_document;
+
+namespace {
+constexpr int64_t DAY_MS = 24LL * 60 * 60 * 1000;
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string string_field(const bsoncxx::document::view& doc, const char* key) {
+    auto element = doc[key];
+    return element && element.type() == bsoncxx::type::k_string ? std::string(element.get_string().value) : "";
+}
+
+int64_t int64_field(const bsoncxx::document::view& doc, const char* key) {
+    auto element = doc[key];
+    if (!element) return 0;
+    if (element.type() == bsoncxx::type::k_int64) return element.get_int64().value;
+    if (element.type() == bsoncxx::type::k_int32) return element.get_int32().value;
+    return 0;
+}
+
+json document_field(const bsoncxx::document::view& doc, const char* key) {
+    auto element = doc[key];
+    if (!element || element.type() != bsoncxx::type::k_document) return nullptr;
+    return json::parse(bsoncxx::to_json(element.get_document().view()));
+}
+
+bool write_all(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written <= 0) return false;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+}
+
+SnapshotStore::SnapshotStore(const Config& cfg, DeviceCache& cache, DeviceStateTable& states, SketchStore& sketch_store,
+                             LogPartitions& log_partitions)
+    : config(cfg), device_cache(cache), device_states(states), sketches(sketch_store), partitions(log_partitions) {}
+
+SnapshotStore::~SnapshotStore() {
+    stop();
+}
+
+bool SnapshotStore::save() {
+    if (!enabled()) return false;
+
+    // 시각을 먼저 기록: 상태를 모으는 동안 들어온 로그는 복원 시 다시 반영됨 (누락 대신 중복 허용)
+    int64_t created_at = now_ms();
+    json snapshot;
+    snapshot["version"] = FORMAT_VERSION;
+    snapshot["created_at"] = created_at;
+    snapshot["devices"] = device_cache.snapshot();
+    snapshot["device_states"] = device_states.snapshot();
+    snapshot["sketches"] = sketches.snapshot();
+    std::vector<uint8_t> bytes = json::to_msgpack(snapshot);
+
+    const std::string& path = config.snapshot_path();
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error opening snapshot file: " << tmp_path << std::endl;
+        return false;
+    }
+    bool ok = write_all(fd, bytes.data(), bytes.size()) && ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error writing snapshot file: " << path << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    last_saved_at = created_at;
+    last_saved_bytes = bytes.size();
+    return true;
+}
+
+bool SnapshotStore::load(CollectionHandles& handles) {
+    if (!enabled()) return false;
+    auto started = std::chrono::steady_clock::now();
+
+    const std::string& path = config.snapshot_path();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cout << "No snapshot found at " << path << ", starting cold" << std::endl;
+        return false;
+    }
+
+    json snapshot;
+    try {
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || info.st_size == 0) throw std::runtime_error("empty snapshot file");
+        size_t size = static_cast<size_t>(info.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) throw std::runtime_error("mmap failed");
+        const auto* data = static_cast<const uint8_t*>(mapped);
+        try {
+            snapshot = json::from_msgpack(data, data + size);
+        } catch (...) {
+            ::munmap(mapped, size);
+            throw;
+        }
+        ::munmap(mapped, size);
+        ::close(fd);
+    } catch (const std::exception& e) {
+        ::close(fd);
+        std::cerr << "Error reading snapshot " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    try {
+        if (snapshot.value("version", 0) != FORMAT_VERSION) {
+            throw std::runtime_error("unsupported snapshot version");
+        }
+        int64_t created_at = snapshot.at("created_at").get<int64_t>();
+        int64_t age_ms = now_ms() - created_at;
+        if (age_ms > config.snapshot_max_age_sec() * 1000) {
+            std::cout << "Snapshot is " << age_ms / 1000 << "s old (max " << config.snapshot_max_age_sec()
+                      << "s), starting cold" << std::endl;
+            return false;
+        }
+
+        device_cache.restore(snapshot.at("devices"), age_ms);
+        for (const auto& state : snapshot.at("device_states")) {
+            device_states.restore(state);
+        }
+        try {
+            sketches.restore(snapshot.at("sketches"));
+        } catch (const std::exception& e) {
+            std::cerr << "Discarding snapshot sketches: " << e.what() << std::endl;
+            sketches.clear();
+        }
+
+        // 스냅샷 이후 저장된 문서만 다시 반영 (실패하면 스케치는 처음부터 다시 쌓음)
+        try {
+            caught_up = catch_up(handles, created_at);
+        } catch (const std::exception& e) {
+            std::cerr << "Error catching up from snapshot: " << e.what() << std::endl;
+            sketches.clear();
+        }
+        loaded_from = created_at;
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid snapshot " << path << ": " << e.what() << std::endl;
+        sketches.clear();
+        return false;
+    }
+
+    ready_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    std::cout << "Snapshot restored from " << path << " (" << caught_up.load() << " documents caught up in "
+              << ready_ms.load() << " ms)" << std::endl;
+    return true;
+}
+
+size_t SnapshotStore::catch_up(CollectionHandles& handles, int64_t since) {
+    size_t count = 0;
+
+    // 로그: 최신 상태(이벤트 시각 기준)와 스케치(이벤트 시각 구간)는 반영 순서와 무관하므로 정렬하지 않음
+    auto log_filter = bson_builder{}
+        << "ingestion_time" << open_document << "$gt" << bsoncxx::types::b_int64{since} << close_document
+        << finalize;
+    // 파티션 사용 시 timestamp가 스냅샷 시각 하루 전 이후인 파티션만 오래된 것부터 읽음
+    // (장비 시계가 하루 이상 늦은 로그는 따라잡기 대상에서 제외)
+    auto names = partitions.select(true, since - DAY_MS, std::numeric_limits<int64_t>::max());
+    auto index_keys = bson_builder{} << "ingestion_time" << 1 << finalize;
+    for (auto it = names.rbegin(); it != names.rend(); ++it) {
+        auto& collection = handles.collection(*it);
+        // ingestion_time 인덱스가 없으면 매 기동마다 컬렉션 전체를 스캔하므로 먼저 생성 (이미 있으면 그대로)
+        try {
+            collection.create_index(index_keys.view());
+        } catch (const std::exception& e) {
+            std::cerr << "Error creating ingestion_time index on " << *it << ": " << e.what() << std::endl;
+        }
+        for (auto&& doc : collection.find(log_filter.view())) {
+            std::string device_id = string_field(doc, "device_id");
+            if (device_id.empty()) continue;
+            std::string log_code = string_field(doc, "log_code");
+            std::string log_level = string_field(doc, "log_level");
+            std::string message = string_field(doc, "message");
+            int64_t timestamp = int64_field(doc, "timestamp");
+
+            device_states.update_log(device_id, log_code, log_level, string_field(doc, "severity"),
+                                     message, timestamp, int64_field(doc, "ingestion_time"));
+            sketches.record(device_id, log_level, log_code, message, document_field(doc, "metadata"), timestamp);
+            ++count;
+        }
+    }
+
+    // 통계(INF): 디바이스별로 created_at이 가장 늦은 문서만 조회 응답 형식으로 반영 (정렬 없이 스캔)
+    auto stats_filter = bson_builder{}
+        << "created_at" << open_document << "$gt" << bsoncxx::types::b_date{std::chrono::milliseconds{since}}
+        << close_document << finalize;
+    std::unordered_map<std::string, std::pair<int64_t, json>> latest_statistics;
+    for (auto&& doc : handles.collection(config.statistics_collection()).find(stats_filter.view())) {
+        std::string device_id = string_field(doc, "device_id");
+        if (device_id.empty()) continue;
+        int64_t created_at = doc["created_at"] && doc["created_at"].type() == bsoncxx::type::k_date
+            ? doc["created_at"].get_date().to_int64() : since;
+        ++count;
+
+        auto it = latest_statistics.find(device_id);
+        if (it != latest_statistics.end() && it->second.first > created_at) continue;
+        latest_statistics[device_id] = {created_at,
+                                        json{{"log_code", string_field(doc, "log_code")},
+                                             {"message", document_field(doc, "statistics")},
+                                             {"time_range", document_field(doc, "time_range")}}};
+    }
+    for (const auto& [device_id, latest] : latest_statistics) {
+        device_states.update_statistics(device_id, latest.second, latest.first);
+    }
+    return count;
+}
+
+void SnapshotStore::start() {
+    if (!enabled() || running.exchange(true)) return;
+    worker = std::thread(&SnapshotStore::run, this);
+    std::cout << "Snapshots enabled: " << config.snapshot_path() << " (interval "
+              << config.snapshot_interval_sec() << "s)" << std::endl;
+}
+
+void SnapshotStore::stop() {
+    if (!running.exchange(false)) return;
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void SnapshotStore::run() {
+    while (running) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait_for(lock, std::chrono::seconds(config.snapshot_interval_sec()), [this] { return !running; });
+        if (!running) break;
+        lock.unlock();
+
+        try {
+            save();
+        } catch (const std::exception& e) {
+            std::cerr << "Error saving snapshot: " << e.what() << std::endl;
+        }
+    }
+}
+
+json SnapshotStore::stats() const {
+    json result;
+    result["enabled"] = enabled();
+    result["last_saved_at"] = last_saved_at.load();
+    result["last_saved_bytes"] = last_saved_bytes.load();
+    result["loaded_from"] = loaded_from.load();
+    result["caught_up"] = caught_up.load();
+    result["ready_ms"] = ready_ms.load();
+    return result;
+}
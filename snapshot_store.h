@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <nlohmann/json.hpp>
+#include "config.h"
+#include "device_cache.h"
+#include "device_state_table.h"
+#include "sketches.h"
+#include "collection_handles.h"
+#include "log_partitions.h"
+
+using json = nlohmann::json;
+
+// 재시작 시 빠르게 응답하기 위한 메모리 상태 스냅샷
+// 디바이스 캐시, 최신 상태 테이블, 통계 스케치를 MessagePack 파일 하나로 주기적으로 저장하고
+// (임시 파일에 쓴 뒤 rename), 시작 시 mmap으로 읽어 복원한 다음 스냅샷 이후 저장된 로그만 다시 반영한다.
+class SnapshotStore {
+private:
+    static constexpr int FORMAT_VERSION = 1;
+
+    const Config& config;
+    DeviceCache& device_cache;
+    DeviceStateTable& device_states;
+    SketchStore& sketches;
+    LogPartitions& partitions;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<bool> running{false};
+
+    std::atomic<int64_t> last_saved_at{0};
+    std::atomic<size_t> last_saved_bytes{0};
+    std::atomic<int64_t> loaded_from{0};       // 복원한 스냅샷 시각 (0이면 복원 안 함)
+    std::atomic<size_t> caught_up{0};          // 복원 후 다시 반영한 문서 수
+    std::atomic<int64_t> ready_ms{0};          // 복원 + 따라잡기 소요 시간
+
+    void run();
+
+    // since 이후 저장된 로그/통계를 메모리 상태에 반영 (반영한 문서 수)
+    size_t catch_up(CollectionHandles& handles, int64_t since);
+
+public:
+    SnapshotStore(const Config& cfg, DeviceCache& cache, DeviceStateTable& states, SketchStore& sketch_store,
+                  LogPartitions& log_partitions);
+    ~SnapshotStore();
+
+    bool enabled() const { return !config.snapshot_path().empty(); }
+
+    // 최신 스냅샷 복원 후 MongoDB에서 따라잡기 (스냅샷이 없거나 오래됐으면 false)
+    bool load(CollectionHandles& handles);
+
+    // 현재 상태 저장 (임시 파일 + rename)
+    bool save();
+
+    // SNAPSHOT_INTERVAL_SEC 마다 저장하는 스레드
+    void start();
+    void stop();
+
+    json stats() const;
+};
@@ -0,0 +1,249 @@
+#include "stats_kernels.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define STATS_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace stats_kernels {
+
+namespace {
+constexpr double POS_INF = std::numeric_limits<double>::infinity();
+constexpr double NEG_INF = -std::numeric_limits<double>::infinity();
+
+void finish(RangeAggregate& result, double min_value, double max_value) {
+    result.min = result.count > 0 ? min_value : 0.0;
+    result.max = result.count > 0 ? max_value : 0.0;
+}
+
+RangeAggregate scalar_impl(const int64_t* ts, const uint32_t* dev, const double* val, size_t n,
+                           uint32_t device, int64_t start_time, int64_t end_time) {
+    RangeAggregate result;
+    double min_value = POS_INF;
+    double max_value = NEG_INF;
+
+    for (size_t i = 0; i < n; ++i) {
+        bool selected = dev[i] == device && ts[i] >= start_time && ts[i] <= end_time && !std::isnan(val[i]);
+        if (!selected) continue;
+
+        ++result.numeric;
+        if (ts[i] >= result.latest_timestamp) {
+            result.latest_timestamp = ts[i];
+            result.latest_value = val[i];
+        }
+        if (val[i] > 0.0) {
+            result.sum += val[i];
+            ++result.count;
+            min_value = std::min(min_value, val[i]);
+            max_value = std::max(max_value, val[i]);
+        }
+    }
+    finish(result, min_value, max_value);
+    return result;
+}
+
+#ifdef STATS_KERNELS_X86
+
+__attribute__((target("avx2")))
+RangeAggregate avx2_impl(const int64_t* ts, const uint32_t* dev, const double* val, size_t n,
+                         uint32_t device, int64_t start_time, int64_t end_time) {
+    const __m256i lo = _mm256_set1_epi64x(start_time);
+    const __m256i hi = _mm256_set1_epi64x(end_time);
+    const __m256i wanted = _mm256_set1_epi64x(device);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d pos_inf = _mm256_set1_pd(POS_INF);
+    const __m256d neg_inf = _mm256_set1_pd(NEG_INF);
+
+    __m256d sum = zero;
+    __m256d min_v = pos_inf;
+    __m256d max_v = neg_inf;
+    __m256i latest_ts = _mm256_set1_epi64x(INT64_MIN);
+    __m256d latest_v = zero;
+    size_t count = 0;
+    size_t numeric = 0;
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ts + i));
+        __m256i d = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(dev + i)));
+        __m256d v = _mm256_loadu_pd(val + i);
+
+        // start_time - 1 과 비교하면 start_time == INT64_MIN 에서 넘침 → lo > t 로 범위 밖 판정
+        __m256i out_of_range = _mm256_or_si256(_mm256_cmpgt_epi64(t, hi), _mm256_cmpgt_epi64(lo, t));
+        __m256i selected_i = _mm256_andnot_si256(out_of_range, _mm256_cmpeq_epi64(d, wanted));
+        __m256d selected = _mm256_and_pd(_mm256_castsi256_pd(selected_i), _mm256_cmp_pd(v, v, _CMP_ORD_Q));
+        __m256d positive = _mm256_and_pd(selected, _mm256_cmp_pd(v, zero, _CMP_GT_OQ));
+
+        int selected_mask = _mm256_movemask_pd(selected);
+        if (selected_mask == 0) continue;
+        int positive_mask = _mm256_movemask_pd(positive);
+
+        numeric += __builtin_popcount(selected_mask);
+        count += __builtin_popcount(positive_mask);
+        sum = _mm256_add_pd(sum, _mm256_and_pd(v, positive));
+        min_v = _mm256_min_pd(min_v, _mm256_blendv_pd(pos_inf, v, positive));
+        max_v = _mm256_max_pd(max_v, _mm256_blendv_pd(neg_inf, v, positive));
+
+        // 레인별 최신 값 갱신 (선택된 레인 중 timestamp >= 현재 최신)
+        __m256i newer = _mm256_andnot_si256(_mm256_cmpgt_epi64(latest_ts, t), _mm256_castpd_si256(selected));
+        latest_ts = _mm256_blendv_epi8(latest_ts, t, newer);
+        latest_v = _mm256_blendv_pd(latest_v, v, _mm256_castsi256_pd(newer));
+    }
+
+    alignas(32) double sum_lanes[4], min_lanes[4], max_lanes[4], latest_v_lanes[4];
+    alignas(32) int64_t latest_ts_lanes[4];
+    _mm256_store_pd(sum_lanes, sum);
+    _mm256_store_pd(min_lanes, min_v);
+    _mm256_store_pd(max_lanes, max_v);
+    _mm256_store_pd(latest_v_lanes, latest_v);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(latest_ts_lanes), latest_ts);
+
+    RangeAggregate result = scalar_impl(ts + i, dev + i, val + i, n - i, device, start_time, end_time);
+    double min_value = result.count > 0 ? result.min : POS_INF;
+    double max_value = result.count > 0 ? result.max : NEG_INF;
+    result.count += count;
+    result.numeric += numeric;
+    for (int lane = 0; lane < 4; ++lane) {
+        result.sum += sum_lanes[lane];
+        min_value = std::min(min_value, min_lanes[lane]);
+        max_value = std::max(max_value, max_lanes[lane]);
+        if (latest_ts_lanes[lane] > result.latest_timestamp) {
+            result.latest_timestamp = latest_ts_lanes[lane];
+            result.latest_value = latest_v_lanes[lane];
+        }
+    }
+    finish(result, min_value, max_value);
+    return result;
+}
+
+__attribute__((target("sse4.2")))
+RangeAggregate sse42_impl(const int64_t* ts, const uint32_t* dev, const double* val, size_t n,
+                          uint32_t device, int64_t start_time, int64_t end_time) {
+    const __m128i lo = _mm_set1_epi64x(start_time);
+    const __m128i hi = _mm_set1_epi64x(end_time);
+    const __m128i wanted = _mm_set1_epi64x(device);
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d pos_inf = _mm_set1_pd(POS_INF);
+    const __m128d neg_inf = _mm_set1_pd(NEG_INF);
+
+    __m128d sum = zero;
+    __m128d min_v = pos_inf;
+    __m128d max_v = neg_inf;
+    __m128i latest_ts = _mm_set1_epi64x(INT64_MIN);
+    __m128d latest_v = zero;
+    size_t count = 0;
+    size_t numeric = 0;
+
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ts + i));
+        __m128i d = _mm_cvtepu32_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(dev + i)));
+        __m128d v = _mm_loadu_pd(val + i);
+
+        __m128i out_of_range = _mm_or_si128(_mm_cmpgt_epi64(t, hi), _mm_cmpgt_epi64(lo, t));
+        __m128i selected_i = _mm_andnot_si128(out_of_range, _mm_cmpeq_epi64(d, wanted));
+        __m128d selected = _mm_and_pd(_mm_castsi128_pd(selected_i), _mm_cmpord_pd(v, v));
+        __m128d positive = _mm_and_pd(selected, _mm_cmpgt_pd(v, zero));
+
+        int selected_mask = _mm_movemask_pd(selected);
+        if (selected_mask == 0) continue;
+        int positive_mask = _mm_movemask_pd(positive);
+
+        numeric += __builtin_popcount(selected_mask);
+        count += __builtin_popcount(positive_mask);
+        sum = _mm_add_pd(sum, _mm_and_pd(v, positive));
+        min_v = _mm_min_pd(min_v, _mm_blendv_pd(pos_inf, v, positive));
+        max_v = _mm_max_pd(max_v, _mm_blendv_pd(neg_inf, v, positive));
+
+        __m128i newer = _mm_andnot_si128(_mm_cmpgt_epi64(latest_ts, t), _mm_castpd_si128(selected));
+        latest_ts = _mm_blendv_epi8(latest_ts, t, newer);
+        latest_v = _mm_blendv_pd(latest_v, v, _mm_castsi128_pd(newer));
+    }
+
+    alignas(16) double sum_lanes[2], min_lanes[2], max_lanes[2], latest_v_lanes[2];
+    alignas(16) int64_t latest_ts_lanes[2];
+    _mm_store_pd(sum_lanes, sum);
+    _mm_store_pd(min_lanes, min_v);
+    _mm_store_pd(max_lanes, max_v);
+    _mm_store_pd(latest_v_lanes, latest_v);
+    _mm_store_si128(reinterpret_cast<__m128i*>(latest_ts_lanes), latest_ts);
+
+    RangeAggregate result = scalar_impl(ts + i, dev + i, val + i, n - i, device, start_time, end_time);
+    double min_value = result.count > 0 ? result.min : POS_INF;
+    double max_value = result.count > 0 ? result.max : NEG_INF;
+    result.count += count;
+    result.numeric += numeric;
+    for (int lane = 0; lane < 2; ++lane) {
+        result.sum += sum_lanes[lane];
+        min_value = std::min(min_value, min_lanes[lane]);
+        max_value = std::max(max_value, max_lanes[lane]);
+        if (latest_ts_lanes[lane] > result.latest_timestamp) {
+            result.latest_timestamp = latest_ts_lanes[lane];
+            result.latest_value = latest_v_lanes[lane];
+        }
+    }
+    finish(result, min_value, max_value);
+    return result;
+}
+
+#endif
+
+using AggregateFn = RangeAggregate (*)(const int64_t*, const uint32_t*, const double*, size_t,
+                                       uint32_t, int64_t, int64_t);
+
+struct Dispatch {
+    AggregateFn aggregate = scalar_impl;
+    const char* isa = "scalar";
+
+    Dispatch() {
+#ifdef STATS_KERNELS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            aggregate = avx2_impl;
+            isa = "avx2";
+        } else if (__builtin_cpu_supports("sse4.2")) {
+            aggregate = sse42_impl;
+            isa = "sse4.2";
+        }
+#endif
+    }
+};
+
+const Dispatch& dispatch() {
+    static const Dispatch instance;
+    return instance;
+}
+}
+
+void RangeAggregate::merge(const RangeAggregate& other) {
+    if (other.count > 0) {
+        min = count > 0 ? std::min(min, other.min) : other.min;
+        max = count > 0 ? std::max(max, other.max) : other.max;
+    }
+    sum += other.sum;
+    count += other.count;
+    numeric += other.numeric;
+    if (other.numeric > 0 && other.latest_timestamp >= latest_timestamp) {
+        latest_timestamp = other.latest_timestamp;
+        latest_value = other.latest_value;
+    }
+}
+
+RangeAggregate aggregate_range(const int64_t* timestamps, const uint32_t* devices, const double* values,
+                               size_t n, uint32_t device, int64_t start_time, int64_t end_time) {
+    return dispatch().aggregate(timestamps, devices, values, n, device, start_time, end_time);
+}
+
+RangeAggregate aggregate_range_scalar(const int64_t* timestamps, const uint32_t* devices, const double* values,
+                                      size_t n, uint32_t device, int64_t start_time, int64_t end_time) {
+    return scalar_impl(timestamps, devices, values, n, device, start_time, end_time);
+}
+
+const char* active_isa() {
+    return dispatch().isa;
+}
+
+}
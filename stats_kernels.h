@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 숫자 텔레메트리 집계 커널 (컬럼 배열 입력)
+// AVX2 / SSE4.2 구현을 실행 시 CPU 기능에 따라 선택하고, 그 외에는 스칼라 구현을 사용한다.
+namespace stats_kernels {
+
+// 시간 범위 + 디바이스 조건으로 필터링한 집계 결과
+// sum/count/min/max는 값 > 0 인 로그만 (기존 $gt: 0 속도 필터와 동일), latest는 숫자 로그 전체 기준
+struct RangeAggregate {
+    double sum = 0.0;
+    size_t count = 0;
+    size_t numeric = 0;
+    double min = 0.0;
+    double max = 0.0;
+    int64_t latest_timestamp = INT64_MIN;
+    double latest_value = 0.0;
+
+    void merge(const RangeAggregate& other);
+};
+
+// timestamp/device/value 컬럼에서 [start_time, end_time] 구간, device 일치, NaN 아닌 값 집계
+RangeAggregate aggregate_range(const int64_t* timestamps,
+                               const uint32_t* devices,
+                               const double* values,
+                               size_t n,
+                               uint32_t device,
+                               int64_t start_time,
+                               int64_t end_time);
+
+// 디스패치 없이 스칼라 구현 직접 호출 (비교/검증용)
+RangeAggregate aggregate_range_scalar(const int64_t* timestamps,
+                                      const uint32_t* devices,
+                                      const double* values,
+                                      size_t n,
+                                      uint32_t device,
+                                      int64_t start_time,
+                                      int64_t end_time);
+
+// 현재 선택된 구현 ("avx2" / "sse4.2" / "scalar")
+const char* active_isa();
+
+}
@@ -0,0 +1,27 @@
+#include "string_util.h"
+
+namespace string_util {
+
+bool parse_numeric(const std::string& message, double& value) {
+    if (message.empty() || message.size() > 15) return false;
+    double result = 0.0;
+    for (char c : message) {
+        if (c < '0' || c > '9') return false;
+        result = result * 10 + (c - '0');
+    }
+    value = result;
+    return true;
+}
+
+bool is_numeric(const std::string& message) {
+    double value;
+    return parse_numeric(message, value);
+}
+
+std::string trim(const std::string& value) {
+    size_t begin = value.find_first_not_of(" \t");
+    size_t end = value.find_last_not_of(" \t");
+    return begin == std::string::npos ? "" : value.substr(begin, end - begin + 1);
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+
+// 로그 메시지 / 설정 문자열 공용 파싱 함수
+namespace string_util {
+
+// 숫자 메시지 ("^[0-9]+$", 최대 15자리)를 값으로 변환 (아니면 false)
+bool parse_numeric(const std::string& message, double& value);
+
+// 숫자 메시지 여부 (parse_numeric과 같은 기준)
+bool is_numeric(const std::string& message);
+
+// 앞뒤 공백 / 탭 제거
+std::string trim(const std::string& value);
+
+}
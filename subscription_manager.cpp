@@ -0,0 +1,131 @@
+#include "subscription_manager.h"
+#include <iostream>
+#include <algorithm>
+
+SubscriptionManager::SubscriptionManager(const Config& cfg)
+    : config(cfg), last_sweep(clock::now()) {}
+
+int64_t SubscriptionManager::clamp_lease(int64_t lease_ms) const {
+    if (lease_ms <= 0) lease_ms = config.subscription_lease_ms();
+    return std::min(lease_ms, config.subscription_max_lease_ms());
+}
+
+void SubscriptionManager::remove_locked(const std::string& id) {
+    auto it = subscriptions.find(id);
+    if (it == subscriptions.end()) return;
+
+    const std::string& device_id = it->second.filter.device_id;
+    if (device_id.empty()) {
+        any_device.erase(id);
+    } else {
+        auto dev_it = by_device.find(device_id);
+        if (dev_it != by_device.end()) {
+            dev_it->second.erase(id);
+            if (dev_it->second.empty()) by_device.erase(dev_it);
+        }
+    }
+    subscriptions.erase(it);
+}
+
+size_t SubscriptionManager::sweep_locked(clock::time_point now) {
+    last_sweep = now;
+
+    std::vector<std::string> expired;
+    for (const auto& [id, sub] : subscriptions) {
+        if (sub.expires_at <= now) expired.push_back(id);
+    }
+    for (const auto& id : expired) {
+        remove_locked(id);
+    }
+    if (!expired.empty()) {
+        std::cout << "Expired " << expired.size() << " subscriptions ("
+                  << subscriptions.size() << " active)" << std::endl;
+    }
+    return expired.size();
+}
+
+bool SubscriptionManager::subscribe(const std::string& id, const LogFilter& filter,
+                                    int64_t lease_ms, Subscription& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = clock::now();
+    sweep_locked(now);
+
+    if (subscriptions.size() >= config.subscription_max_count()) {
+        return false;
+    }
+
+    Subscription sub;
+    sub.id = id;
+    sub.filter = filter;
+    sub.topic = config.subscription_topic_prefix() + id;
+    sub.lease_ms = clamp_lease(lease_ms);
+    sub.expires_at = now + std::chrono::milliseconds(sub.lease_ms);
+
+    if (filter.device_id.empty()) {
+        any_device.insert(id);
+    } else {
+        by_device[filter.device_id].insert(id);
+    }
+    out = sub;
+    subscriptions.emplace(id, std::move(sub));
+    return true;
+}
+
+bool SubscriptionManager::renew(const std::string& id, int64_t lease_ms, Subscription& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = subscriptions.find(id);
+    if (it == subscriptions.end()) return false;
+
+    it->second.lease_ms = clamp_lease(lease_ms);
+    it->second.expires_at = clock::now() + std::chrono::milliseconds(it->second.lease_ms);
+    out = it->second;
+    return true;
+}
+
+bool SubscriptionManager::unsubscribe(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (subscriptions.find(id) == subscriptions.end()) return false;
+    remove_locked(id);
+    return true;
+}
+
+std::vector<SubscriptionManager::Target> SubscriptionManager::match(
+    const std::string& device_id, const std::string& log_level,
+    const std::string& log_code, const std::string& severity, int64_t timestamp) {
+    std::vector<Target> targets;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (subscriptions.empty()) return targets;
+
+    // 만료 정리는 최대 1초에 한 번만 수행
+    auto now = clock::now();
+    if (now - last_sweep >= std::chrono::seconds(1)) {
+        sweep_locked(now);
+    }
+
+    auto check = [&](const std::string& id) {
+        auto it = subscriptions.find(id);
+        if (it == subscriptions.end() || it->second.expires_at <= now) return;
+        if (it->second.filter.matches(device_id, log_level, log_code, severity, timestamp)) {
+            targets.push_back({it->second.id, it->second.topic});
+        }
+    };
+
+    auto dev_it = by_device.find(device_id);
+    if (dev_it != by_device.end()) {
+        for (const auto& id : dev_it->second) check(id);
+    }
+    for (const auto& id : any_device) check(id);
+
+    return targets;
+}
+
+bool SubscriptionManager::empty() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return subscriptions.empty();
+}
+
+size_t SubscriptionManager::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return subscriptions.size();
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include "config.h"
+#include "log_filter.h"
+
+// 실시간 로그 구독 관리 (query_type == "subscribe")
+// 구독은 device_id 기준으로 인덱싱되어 수신 로그마다 해당 디바이스 구독만 검사한다.
+class SubscriptionManager {
+public:
+    using clock = std::chrono::steady_clock;
+
+    struct Subscription {
+        std::string id;
+        LogFilter filter;
+        std::string topic;
+        int64_t lease_ms = 0;
+        clock::time_point expires_at;
+    };
+
+    // 매칭된 구독의 전송 대상
+    struct Target {
+        std::string subscription_id;
+        std::string topic;
+    };
+
+private:
+    const Config& config;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Subscription> subscriptions;
+    std::unordered_map<std::string, std::unordered_set<std::string>> by_device;
+    std::unordered_set<std::string> any_device;
+    clock::time_point last_sweep;
+
+    int64_t clamp_lease(int64_t lease_ms) const;
+    void remove_locked(const std::string& id);
+    size_t sweep_locked(clock::time_point now);
+
+public:
+    SubscriptionManager(const Config& cfg);
+
+    // 구독 등록 (최대 개수 초과 시 false)
+    bool subscribe(const std::string& id, const LogFilter& filter, int64_t lease_ms, Subscription& out);
+
+    // lease 연장 / 구독 해지
+    bool renew(const std::string& id, int64_t lease_ms, Subscription& out);
+    bool unsubscribe(const std::string& id);
+
+    // 수신 로그와 매칭되는 구독 목록 (만료된 구독은 이 과정에서 정리)
+    std::vector<Target> match(const std::string& device_id,
+                              const std::string& log_level,
+                              const std::string& log_code,
+                              const std::string& severity,
+                              int64_t timestamp);
+
+    bool empty() const;
+    size_t size() const;
+};
@@ -0,0 +1,185 @@
+#include "telemetry_record.h"
+#include <vector>
+
+namespace {
+// 최상위 고정 필드는 바로 채우고, metadata 하위 트리만 json으로 구성
+class TelemetrySax : public nlohmann::json_sax<json> {
+private:
+    TelemetryRecord& record;
+    int depth = 0;
+    std::string field;                 // 현재 최상위 키
+    std::vector<json*> stack;          // metadata 내부 컨테이너
+    std::string pending_key;
+
+    // metadata 내부 값 추가
+    template<typename T>
+    bool put(T&& value) {
+        json* parent = stack.back();
+        if (parent->is_object()) {
+            (*parent)[pending_key] = std::forward<T>(value);
+        } else {
+            parent->push_back(std::forward<T>(value));
+        }
+        return true;
+    }
+
+    bool in_metadata() const { return !stack.empty(); }
+
+    // 최상위 스칼라 값
+    bool top_level_number(int64_t value) {
+        if (field == "timestamp") {
+            record.timestamp = value;
+            record.has_timestamp = true;
+        } else {
+            record.structured = true;
+        }
+        return true;
+    }
+
+public:
+    explicit TelemetrySax(TelemetryRecord& out) : record(out) {}
+
+    bool null() override {
+        if (in_metadata()) return put(nullptr);
+        return true;
+    }
+
+    bool boolean(bool value) override {
+        if (in_metadata()) return put(value);
+        if (depth == 1) record.structured = true;
+        return true;
+    }
+
+    bool number_integer(number_integer_t value) override {
+        if (in_metadata()) return put(value);
+        if (depth == 1) return top_level_number(value);
+        return true;
+    }
+
+    bool number_unsigned(number_unsigned_t value) override {
+        if (in_metadata()) return put(value);
+        if (depth == 1) return top_level_number(static_cast<int64_t>(value));
+        return true;
+    }
+
+    bool number_float(number_float_t value, const string_t&) override {
+        if (in_metadata()) return put(value);
+        if (depth == 1) return top_level_number(static_cast<int64_t>(value));
+        return true;
+    }
+
+    bool string(string_t& value) override {
+        if (in_metadata()) return put(std::move(value));
+        if (depth != 1) return true;
+        if (field == "log_code") {
+            record.log_code = std::move(value);
+        } else if (field == "message") {
+            record.message = std::move(value);
+        } else {
+            record.structured = true;
+        }
+        return true;
+    }
+
+    bool binary(binary_t&) override {
+        if (depth >= 1) record.structured = true;
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        ++depth;
+        if (in_metadata()) {
+            put(json::object());
+            json* parent = stack.back();
+            stack.push_back(parent->is_object() ? &(*parent)[pending_key] : &parent->back());
+        } else if (depth == 2 && field == "metadata") {
+            record.metadata = json::object();
+            stack.push_back(&record.metadata);
+        } else if (depth == 2) {
+            record.structured = true;   // message/time_range 객체 (INF 통계)
+        }
+        return true;
+    }
+
+    bool key(string_t& value) override {
+        if (in_metadata()) {
+            pending_key = std::move(value);
+        } else if (depth == 1) {
+            field = std::move(value);
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        if (in_metadata()) stack.pop_back();
+        --depth;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        ++depth;
+        if (in_metadata()) {
+            put(json::array());
+            json* parent = stack.back();
+            stack.push_back(parent->is_object() ? &(*parent)[pending_key] : &parent->back());
+        } else if (depth <= 2) {
+            record.structured = true;
+        }
+        return true;
+    }
+
+    bool end_array() override {
+        if (in_metadata()) stack.pop_back();
+        --depth;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+        return false;
+    }
+};
+}
+
+bool TelemetryRecord::decode(const std::string& payload, PayloadFormat format, TelemetryRecord& out) {
+    out = TelemetryRecord{};
+    TelemetrySax handler(out);
+
+    bool ok = false;
+    switch (format) {
+        case PayloadFormat::CBOR:
+            ok = json::sax_parse(payload.begin(), payload.end(), &handler, json::input_format_t::cbor);
+            break;
+        case PayloadFormat::MSGPACK:
+            ok = json::sax_parse(payload.begin(), payload.end(), &handler, json::input_format_t::msgpack);
+            break;
+        case PayloadFormat::JSON:
+        default:
+            ok = json::sax_parse(payload.begin(), payload.end(), &handler, json::input_format_t::json, false);
+            break;
+    }
+    if (out.log_code.empty()) out.log_code = "UNKNOWN";
+    return ok;
+}
+
+json TelemetryRecord::decode_document(const std::string& payload, PayloadFormat format) {
+    switch (format) {
+        case PayloadFormat::CBOR: return json::from_cbor(payload);
+        case PayloadFormat::MSGPACK: return json::from_msgpack(payload);
+        case PayloadFormat::JSON:
+        default: return json::parse(payload);
+    }
+}
+
+TelemetryRecord TelemetryRecord::from_json(const json& payload) {
+    TelemetryRecord record;
+    record.log_code = payload.value("log_code", "UNKNOWN");
+    record.message = payload.value("message", "");
+    if (payload.contains("timestamp")) {
+        record.timestamp = payload["timestamp"].get<int64_t>();
+        record.has_timestamp = true;
+    }
+    if (payload.contains("metadata") && payload["metadata"].is_object()) {
+        record.metadata = payload["metadata"];
+    }
+    return record;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "topic_router.h"
+
+using json = nlohmann::json;
+
+// 디바이스 로그 페이로드의 고정 필드 (log_code, message, timestamp, metadata)
+// 바이너리(CBOR/MessagePack) 페이로드는 SAX 방식으로 DOM 없이 바로 이 구조체로 디코딩한다.
+struct TelemetryRecord {
+    std::string log_code;
+    std::string message;
+    int64_t timestamp = 0;
+    bool has_timestamp = false;
+    json metadata;             // 가변 스키마라 하위 트리만 json으로 보관 (없으면 null)
+
+    // message가 문자열이 아니거나 정의되지 않은 최상위 필드가 있음 (INF 통계 등)
+    // 이 경우 호출 측은 전체 문서로 다시 디코딩해 기존 경로로 처리한다.
+    bool structured = false;
+
+    static bool decode(const std::string& payload, PayloadFormat format, TelemetryRecord& out);
+    static json decode_document(const std::string& payload, PayloadFormat format);
+    static TelemetryRecord from_json(const json& payload);
+};
@@ -0,0 +1,64 @@
+// DDSketch 분위수 검증 (cmake -DBUILD_TESTS=ON && ctest)
+#include "sketches.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+int failures = 0;
+
+void expect_near(const char* name, double actual, double expected, double relative) {
+    double tolerance = std::max(std::fabs(expected) * relative, 1e-9);
+    if (std::fabs(actual - expected) > tolerance) {
+        std::cerr << "FAIL " << name << ": expected " << expected << ", got " << actual << std::endl;
+        ++failures;
+    }
+}
+
+// -50 ~ 50 (음수 50개 / 0 1개 / 양수 50개, q 분위수의 정확한 값은 -50 + 100q)
+DDSketch mixed_sign() {
+    DDSketch sketch(0.01);
+    for (int v = -50; v <= 50; ++v) sketch.add(v);
+    return sketch;
+}
+}
+
+int main() {
+    {
+        DDSketch sketch = mixed_sign();
+        expect_near("min", sketch.quantile(0.0), -50, 0.02);
+        expect_near("p10", sketch.quantile(0.1), -40, 0.02);
+        expect_near("p25", sketch.quantile(0.25), -25, 0.02);
+        expect_near("p50", sketch.quantile(0.5), 0, 0.0);
+        expect_near("p75", sketch.quantile(0.75), 25, 0.02);
+        expect_near("p90", sketch.quantile(0.9), 40, 0.02);
+        expect_near("max", sketch.quantile(1.0), 50, 0.02);
+    }
+
+    // 영하 온도만 있는 경우
+    {
+        DDSketch sketch(0.01);
+        for (int i = 0; i <= 100; ++i) sketch.add(-10.0 - i * 0.1);   // -20.0 ~ -10.0
+        expect_near("negative p1", sketch.quantile(0.01), -19.9, 0.02);
+        expect_near("negative p50", sketch.quantile(0.5), -15.0, 0.02);
+        expect_near("negative p99", sketch.quantile(0.99), -10.1, 0.02);
+    }
+
+    // 병합 / 스냅샷 복원 후에도 같은 결과
+    {
+        DDSketch negative(0.01), positive(0.01);
+        for (int v = -50; v < 0; ++v) negative.add(v);
+        for (int v = 0; v <= 50; ++v) positive.add(v);
+        negative.merge(positive);
+        DDSketch restored(0.01);
+        restored.restore(negative.to_json());
+        DDSketch expected = mixed_sign();
+        for (double q : {0.0, 0.1, 0.25, 0.5, 0.75, 0.9, 1.0}) {
+            expect_near("merged", negative.quantile(q), expected.quantile(q), 1e-12);
+            expect_near("restored", restored.quantile(q), expected.quantile(q), 1e-12);
+        }
+    }
+
+    if (failures == 0) std::cout << "test_sketches: OK" << std::endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,47 @@
+#include "topic_router.h"
+
+PayloadFormat payload_format_from_suffix(std::string_view suffix) {
+    if (suffix == "cbor") return PayloadFormat::CBOR;
+    if (suffix == "msgpack") return PayloadFormat::MSGPACK;
+    return PayloadFormat::JSON;
+}
+
+bool DeviceTopic::parse(std::string_view topic, DeviceTopic& out) {
+    out = DeviceTopic{};
+
+    std::string_view parts[5];
+    size_t count = 0;
+    size_t begin = 0;
+    while (count < 5) {
+        size_t end = topic.find('/', begin);
+        parts[count++] = topic.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin);
+        if (end == std::string_view::npos) {
+            begin = topic.size() + 1;
+            break;
+        }
+        begin = end + 1;
+    }
+    // 세그먼트가 5개를 넘으면 어떤 형식에도 해당하지 않음
+    bool overflow = begin <= topic.size();
+
+    // factory/{device_id}/ 까지는 있어야 함 (device_id는 비어 있으면 안 됨)
+    if (count < 3 || parts[0] != "factory" || parts[1].empty()) return false;
+
+    out.device_id = std::string(parts[1]);
+    out.channel = std::string(parts[2]);
+    if (count > 3) out.level = std::string(parts[3]);
+    if (count > 4) out.suffix = std::string(parts[4]);
+    out.segments = overflow ? count + 1 : count;
+    if (out.segments == 5) out.format = payload_format_from_suffix(out.suffix);
+    return true;
+}
+
+bool DeviceTopic::is_log() const {
+    if (channel != "log" || level.empty()) return false;
+    if (segments == 4) return true;
+    return segments == 5 && format != PayloadFormat::JSON;
+}
+
+bool DeviceTopic::is_batch() const {
+    return channel == "log" && !level.empty() && segments == 5 && suffix == "batch";
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// 디바이스 페이로드 인코딩 (토픽 접미사로 선택)
+enum class PayloadFormat {
+    JSON,
+    CBOR,
+    MSGPACK
+};
+
+// factory/{device_id}/{channel}/{level}[/{suffix}] 토픽 분해 (정규식 없이 '/' 단위로 분리)
+struct DeviceTopic {
+    std::string device_id;
+    std::string channel;   // "log", "msg" 등
+    std::string level;     // channel 다음 세그먼트 (로그 레벨)
+    std::string suffix;    // "cbor" / "msgpack" 등, 없으면 빈 문자열
+    PayloadFormat format = PayloadFormat::JSON;
+    size_t segments = 0;
+
+    // factory/{device_id}/ 로 시작하지 않으면 false
+    static bool parse(std::string_view topic, DeviceTopic& out);
+
+    // factory/{device_id}/log/{level} 또는 .../{level}/{cbor|msgpack}
+    bool is_log() const;
+
+    // factory/{device_id}/log/{level}/batch (JSON 배열로 여러 로그 전송)
+    bool is_batch() const;
+};
+
+PayloadFormat payload_format_from_suffix(std::string_view suffix);
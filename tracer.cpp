@@ -0,0 +1,149 @@
+#include "tracer.h"
+#include <atomic>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+thread_local Tracer::Buffer* Tracer::active = nullptr;
+thread_local uint64_t Tracer::counter = 0;
+thread_local uint32_t Tracer::thread_index = 0;
+
+namespace {
+std::atomic<uint32_t> next_thread_index{1};
+
+int64_t micros(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+}
+
+const char* Tracer::stage_name(Stage stage) {
+    switch (stage) {
+        case PARSE: return "parse";
+        case DEVICE_LOOKUP: return "device_lookup";
+        case SEVERITY: return "severity";
+        case INSERT_GROUP: return "insert_group";
+        case INSERT_ALL: return "insert_all";
+        case PUBLISH: return "publish";
+        case QUERY: return "query";
+        case STATISTICS: return "statistics";
+        case TOTAL: return "total";
+        default: return "unknown";
+    }
+}
+
+void Tracer::Histogram::add(uint64_t us) {
+    size_t index = 0;
+    while (index + 1 < BUCKETS && (uint64_t{1} << index) <= us) ++index;
+    ++buckets[index];
+    ++count;
+    max_us = std::max(max_us, us);
+}
+
+uint64_t Tracer::Histogram::quantile(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count - 1));
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        cumulative += buckets[i];
+        // 구간 상한으로 보고 (최대값을 넘지 않게)
+        if (cumulative > rank) return std::min<uint64_t>(i == 0 ? 1 : uint64_t{1} << i, max_us);
+    }
+    return max_us;
+}
+
+Tracer::Tracer(const Config& cfg)
+    : sample_every(static_cast<uint64_t>(cfg.trace_sample_every())),
+      max_events(static_cast<size_t>(cfg.trace_max_events())),
+      dump_path(cfg.trace_dump_path()),
+      origin(Clock::now()) {}
+
+Tracer::Trace::Trace(Tracer& owner, const char* name) : tracer(owner) {
+    if (tracer.sample_every == 0 || active != nullptr) return;
+    if (++counter % tracer.sample_every != 0) return;
+
+    sampled = true;
+    buffer.name = name;
+    buffer.start = Clock::now();
+    active = &buffer;
+}
+
+Tracer::Trace::~Trace() {
+    if (!sampled) return;
+    active = nullptr;
+    buffer.spans.push_back(SpanRecord{TOTAL, buffer.start, Clock::now()});
+    tracer.commit(buffer);
+}
+
+Tracer::Span::Span(Stage span_stage) : buffer(active), stage(span_stage) {
+    if (buffer) start = Clock::now();
+}
+
+void Tracer::Span::end() {
+    if (!buffer) return;
+    buffer->spans.push_back(SpanRecord{stage, start, Clock::now()});
+    buffer = nullptr;
+}
+
+void Tracer::commit(const Buffer& buffer) {
+    if (thread_index == 0) thread_index = next_thread_index++;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++sampled;
+    for (const auto& span : buffer.spans) {
+        int64_t duration = micros(span.end - span.start);
+        histograms[span.stage].add(static_cast<uint64_t>(std::max<int64_t>(duration, 0)));
+
+        if (max_events == 0) continue;
+        events.push_back(Event{buffer.name, span.stage, micros(span.start - origin), duration, thread_index});
+        if (events.size() > max_events) events.pop_front();
+    }
+}
+
+json Tracer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    json result;
+    result["sample_every"] = sample_every;
+    result["sampled"] = sampled;
+    json stages = json::object();
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        const auto& histogram = histograms[i];
+        if (histogram.count == 0) continue;
+        stages[stage_name(static_cast<Stage>(i))] = {
+            {"count", histogram.count},
+            {"p50_us", histogram.quantile(0.50)},
+            {"p90_us", histogram.quantile(0.90)},
+            {"p99_us", histogram.quantile(0.99)},
+            {"max_us", histogram.max_us}
+        };
+    }
+    result["stages"] = stages;
+    return result;
+}
+
+bool Tracer::dump() const {
+    if (dump_path.empty()) return false;
+
+    json trace_events = json::array();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (events.empty()) return false;
+        for (const auto& event : events) {
+            trace_events.push_back({{"name", stage_name(event.stage)},
+                                    {"cat", event.trace},
+                                    {"ph", "X"},
+                                    {"ts", event.ts_us},
+                                    {"dur", event.dur_us},
+                                    {"pid", 1},
+                                    {"tid", event.tid}});
+        }
+    }
+
+    std::ofstream file(dump_path);
+    file << json{{"traceEvents", trace_events}, {"displayTimeUnit", "ms"}}.dump();
+    if (!file) {
+        std::cerr << "Error writing trace file: " << dump_path << std::endl;
+        return false;
+    }
+    std::cout << "Trace written to " << dump_path << " (" << trace_events.size() << " spans)" << std::endl;
+    return true;
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "config.h"
+
+using json = nlohmann::json;
+
+// 메시지 처리 단계별 지연 추적 (샘플링)
+// TRACE_SAMPLE_EVERY번째 메시지마다 스레드 로컬 버퍼에 단계 구간을 기록하고, 메시지가 끝나면
+// 단계별 히스토그램과 Chrome trace-event 링 버퍼에 한 번에 반영한다.
+// 샘플링하지 않는 메시지는 스레드 로컬 포인터 확인만 하므로 비용이 거의 없다.
+class Tracer {
+public:
+    enum Stage : uint8_t {
+        PARSE,
+        DEVICE_LOOKUP,
+        SEVERITY,
+        INSERT_GROUP,
+        INSERT_ALL,
+        PUBLISH,
+        QUERY,
+        STATISTICS,
+        TOTAL,
+        STAGE_COUNT
+    };
+
+    static const char* stage_name(Stage stage);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct SpanRecord {
+        Stage stage;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    struct Buffer {
+        const char* name = nullptr;
+        Clock::time_point start;
+        std::vector<SpanRecord> spans;
+    };
+
+    // 마이크로초 log2 구간 (0: <1us, i: [2^(i-1), 2^i) us)
+    static constexpr size_t BUCKETS = 40;
+    struct Histogram {
+        std::array<uint64_t, BUCKETS> buckets{};
+        uint64_t count = 0;
+        uint64_t max_us = 0;
+        void add(uint64_t us);
+        uint64_t quantile(double q) const;
+    };
+
+    struct Event {
+        const char* trace;
+        Stage stage;
+        int64_t ts_us;
+        int64_t dur_us;
+        uint32_t tid;
+    };
+
+    uint64_t sample_every;
+    size_t max_events;
+    std::string dump_path;
+    Clock::time_point origin;
+
+    mutable std::mutex mutex;
+    std::array<Histogram, STAGE_COUNT> histograms;
+    std::deque<Event> events;
+    uint64_t sampled = 0;
+
+    static thread_local Buffer* active;
+    static thread_local uint64_t counter;
+    static thread_local uint32_t thread_index;
+
+    void commit(const Buffer& buffer);
+
+public:
+    Tracer(const Config& cfg);
+
+    bool enabled() const { return sample_every > 0; }
+
+    // 메시지/요청 하나의 추적 범위 (샘플링된 경우만 기록, 중첩 시 바깥 범위만 유효)
+    class Trace {
+    private:
+        Tracer& tracer;
+        Buffer buffer;
+        bool sampled = false;
+
+    public:
+        Trace(Tracer& tracer, const char* name);
+        ~Trace();
+        Trace(const Trace&) = delete;
+        Trace& operator=(const Trace&) = delete;
+    };
+
+    // 현재 스레드의 추적 범위 안에서 단계 구간 기록
+    class Span {
+    private:
+        Buffer* buffer;
+        Stage stage;
+        Clock::time_point start;
+
+    public:
+        explicit Span(Stage stage);
+        ~Span() { end(); }
+
+        // 범위보다 먼저 구간을 끝낼 때 (이후 호출은 무시)
+        void end();
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+    };
+
+    // 단계별 히스토그램 (count / p50 / p90 / p99 / max, 마이크로초)
+    json stats() const;
+
+    // 최근 샘플 구간을 Chrome trace-event JSON으로 저장 (chrome://tracing, Perfetto)
+    bool dump() const;
+};
@@ -0,0 +1,43 @@
+#include "ulid.h"
+#include <chrono>
+#include <random>
+
+std::string generate_ulid() {
+    static const char* ENCODING = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+    auto now = std::chrono::system_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+
+    std::random_device rd;
+    std::mt19937_64 gen(rd());
+    std::uniform_int_distribution<uint64_t> dis;
+
+    uint64_t rand_high = dis(gen);
+    uint64_t rand_low = dis(gen);
+
+    char ulid[27];
+    ulid[26] = 0;
+
+    // Timestamp (48 bits)
+    ulid[0] = ENCODING[(ms >> 45) & 0x1F];
+    ulid[1] = ENCODING[(ms >> 40) & 0x1F];
+    ulid[2] = ENCODING[(ms >> 35) & 0x1F];
+    ulid[3] = ENCODING[(ms >> 30) & 0x1F];
+    ulid[4] = ENCODING[(ms >> 25) & 0x1F];
+    ulid[5] = ENCODING[(ms >> 20) & 0x1F];
+    ulid[6] = ENCODING[(ms >> 15) & 0x1F];
+    ulid[7] = ENCODING[(ms >> 10) & 0x1F];
+    ulid[8] = ENCODING[(ms >> 5) & 0x1F];
+    ulid[9] = ENCODING[ms & 0x1F];
+
+    // Randomness (80 bits)
+    auto encode_random = [&](uint64_t r, int start_idx) {
+        for (int i = 0; i < 8; ++i) {
+            ulid[start_idx + i] = ENCODING[r & 0x1F];
+            r >>= 5;
+        }
+    };
+    encode_random(rand_low, 10);
+    encode_random(rand_high, 18);
+
+    return std::string(ulid);
+}
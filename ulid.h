@@ -0,0 +1,5 @@
+#pragma once
+#include <string>
+
+// ULID 생성 (48비트 ms 타임스탬프 + 80비트 난수, Crockford Base32 26자)
+std::string generate_ulid();